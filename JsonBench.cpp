@@ -0,0 +1,705 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include "src/Json.h"
+#include "src/JsonSimd.h"
+#include "src/JsonLazy.h"
+#include "src/JsonParser.h"
+#include "src/JsonStream.h"
+#include "src/JsonBatch.h"
+#include "src/JsonAlloc.h"
+#include "src/JsonPointer.h"
+#include "src/JsonPath.h"
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstdio>   // remove, snprintf
+#include <vector>
+
+using namespace std;
+using namespace myJson;
+
+// count every global allocation, the benchmark reports them per parsed document
+static size_t alloc_count = 0;
+
+void* operator new(size_t size) {
+    ++alloc_count;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// pmr::new_delete_resource goes through the aligned versions
+void* operator new(size_t size, align_val_t align) {
+    ++alloc_count;
+    void* p = aligned_alloc((size_t)align, (size + (size_t)align - 1) / (size_t)align * (size_t)align);
+    if (p == NULL) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p, align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t, align_val_t) noexcept {
+    free(p);
+}
+
+// main() installs it as the default resource, it tells which of the global allocations above belong to trees
+static TrackingResource tracker;
+
+// --json prints one json object per result instead of text, so two builds can be compared by a script
+static bool json_output = false;
+
+// bytes is the size of one document (input for parsing, output for stringifying), docs how many were processed in sec
+// tree, if given, is what went through tracker for all docs, i.e. allocations of the trees alone
+static void report(const string& name, const string& op, size_t bytes, size_t docs, double sec, size_t allocs,
+                   const AllocCounts* tree = nullptr) {
+    double mb_per_s = bytes * (double)docs / (1024 * 1024) / sec;
+    double docs_per_s = docs / sec;
+    size_t allocs_per_doc = docs ? allocs / docs : 0;
+    size_t tree_allocs = tree && docs ? tree->allocs / docs : 0;
+    size_t tree_bytes = tree && docs ? tree->bytes / docs : 0;
+    if (json_output) {
+        char buf[512];
+        int len = snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"mb_per_s\":%.2f,"
+                           "\"docs_per_s\":%.2f,\"allocs_per_doc\":%zu", name.c_str(), op.c_str(), bytes, mb_per_s,
+                           docs_per_s, allocs_per_doc);
+        if (tree) {
+            snprintf(buf + len, sizeof(buf) - len, ",\"tree_allocs_per_doc\":%zu,\"tree_bytes_per_doc\":%zu",
+                     tree_allocs, tree_bytes);
+        }
+        cout << buf << "}" << endl;
+    } else {
+        cout << name << " " << op << ": " << bytes << " bytes, " << allocs_per_doc << " allocs/doc, ";
+        if (tree) cout << "tree " << tree_allocs << " allocs/doc " << tree_bytes << " bytes/doc, ";
+        cout << mb_per_s << " MB/s, " << docs_per_s << " docs/s" << endl;
+    }
+}
+
+static double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void check(int ret, const string& name) {
+    if (ret != PARSE_OK) {
+        cerr << name << ": parse failed" << endl;
+        exit(1);
+    }
+}
+
+// build a deterministic document, i.e. an array of records mixing every JSON_TYPE and some nesting
+static string make_document(size_t records) {
+    string json = "[";
+    for (size_t i = 0; i < records; ++i) {
+        if (i > 0) json += ",";
+        json += "{\"id\":" + to_string(i) +
+                ",\"name\":\"user_" + to_string(i * 7919 % 10007) + "\"" +
+                ",\"score\":" + to_string(i % 97) + ".25" +
+                ",\"active\":" + (i % 3 ? "true" : "false") +
+                ",\"parent\":null" +
+                ",\"tags\":[\"alpha\",\"beta\",\"gamma\"]" +
+                ",\"pos\":{\"x\":" + to_string(i % 13) + ",\"y\":-" + to_string(i % 17) + "}}";
+    }
+    json += "]";
+    return json;
+}
+
+// same records pretty-printed with 4 space indent, about a third of the bytes are whitespace
+static string make_pretty_document(size_t records) {
+    string json = "[\n";
+    for (size_t i = 0; i < records; ++i) {
+        if (i > 0) json += ",\n";
+        json += "    {\n        \"id\": " + to_string(i) +
+                ",\n        \"name\": \"user_" + to_string(i * 7919 % 10007) + "\"" +
+                ",\n        \"bio\": \"a longer string without any escape that is copied as one run, user " + to_string(i) + "\"" +
+                ",\n        \"score\": " + to_string(i % 97) + ".25" +
+                ",\n        \"tags\": [\n            \"alpha\",\n            \"beta\"\n        ]\n    }";
+    }
+    json += "\n]\n";
+    return json;
+}
+
+// coordinates like geographic data, every value is a double with 15-17 significant digits
+static string make_number_document(size_t count) {
+    string json = "[";
+    char buf[32];
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) json += ",";
+        snprintf(buf, sizeof(buf), "%.17g", (i % 2 ? -1.0 : 1.0) * (i * 0.618033988749895 + 1.0 / (i + 3)));
+        json += buf;
+    }
+    json += "]";
+    return json;
+}
+
+// a search result of tweet-like statuses, short keys, ids as numbers and strings, text with escapes and non-ASCII
+static string make_tweets(size_t count) {
+    string json = "{\"statuses\":[";
+    for (size_t i = 0; i < count; ++i) {
+        string id = to_string(505874924095815681ULL + i * 7919);
+        if (i > 0) json += ",";
+        json += "{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":" + id + ",\"id_str\":\"" + id + "\"," +
+                "\"text\":\"@user_" + to_string(i % 101) + " \\\"quoted\\\" caf\\u00e9 \\uD83D\\uDE00 see https:\\/\\/t.co\\/" +
+                to_string(i * 31 % 9973) + " #json\",\"truncated\":false," +
+                "\"user\":{\"id\":" + to_string(1186275104 + i % 500) + ",\"name\":\"User " + to_string(i % 500) + "\"," +
+                "\"screen_name\":\"user_" + to_string(i % 500) + "\",\"followers_count\":" + to_string(i * 37 % 100000) + "," +
+                "\"verified\":" + (i % 17 ? "false" : "true") + ",\"profile_image_url\":\"http:\\/\\/pbs.twimg.com\\/profile_images\\/" +
+                to_string(i % 500) + "\\/normal.png\"}," +
+                "\"entities\":{\"hashtags\":[{\"text\":\"json\",\"indices\":[" + to_string(i % 50) + "," + to_string(i % 50 + 5) + "]}]," +
+                "\"urls\":[],\"user_mentions\":[{\"screen_name\":\"user_" + to_string(i % 101) + "\",\"indices\":[0,8]}]}," +
+                "\"retweet_count\":" + to_string(i % 1000) + ",\"favorite_count\":" + to_string(i % 300) + "," +
+                "\"favorited\":false,\"retweeted\":false,\"coordinates\":null,\"lang\":\"" + (i % 3 ? "en" : "ja") + "\"}";
+    }
+    json += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"count\":" + to_string(count) + "}}";
+    return json;
+}
+
+// one polygon feature as in canada.json, rings of [longitude, latitude] pairs with many digits
+static string make_canada(size_t rings, size_t points) {
+    string json = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},"
+                  "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+    char buf[64];
+    for (size_t r = 0; r < rings; ++r) {
+        json += r ? ",[" : "[";
+        for (size_t i = 0; i < points; ++i) {
+            double t = (r * points + i) * 0.001;
+            snprintf(buf, sizeof(buf), "%s[%.15g,%.15g]", i ? "," : "", -65.613616999999977 - t * 0.7071067811865476,
+                     43.420273000000009 + t * 0.3183098861837907);
+            json += buf;
+        }
+        json += "]";
+    }
+    json += "]}}]}";
+    return json;
+}
+
+// count arrays and objects nested depth levels deep, alternating, with one number at the bottom of each
+static string make_deep(size_t count, size_t depth) {
+    string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) json += ",";
+        for (size_t d = 0; d < depth; ++d) json += d % 2 ? "{\"k\":" : "[";
+        json += to_string(i);
+        for (size_t d = depth; d-- > 0; ) json += d % 2 ? "}" : "]";
+    }
+    json += "]";
+    return json;
+}
+
+// long strings where escapes are spread over the text, as in logs or embedded documents
+static string make_escaped_strings(size_t count) {
+    string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) json += ",";
+        json += "\"line " + to_string(i) + ":\\tlevel=\\\"info\\\" path=C:\\\\logs\\\\app.log\\n";
+        json += "a plain run of text which needs no escaping at all and is long enough for the SIMD paths\\n";
+        json += "caf\\u00e9 \\u65e5\\u672c \\uD83D\\uDE00 \\/end\\r\\n\"";
+    }
+    json += "]";
+    return json;
+}
+
+// one record per line, as written by a log shipper
+static string make_ndjson(size_t records) {
+    string json;
+    for (size_t i = 0; i < records; ++i) {
+        json += "{\"id\":" + to_string(i) + ",\"name\":\"user_" + to_string(i % 97) + "\",\"active\":" +
+                (i % 3 ? "true" : "false") + ",\"score\":" + to_string(i % 1000) + ".25,\"tags\":[\"a\",\"b\",\"c\"]," +
+                "\"pos\":{\"x\":" + to_string(i % 13) + ",\"y\":-" + to_string(i % 7) + ".5},\"note\":null}\n";
+    }
+    return json;
+}
+
+static void bench_parse(const string& name, const string& json, size_t iterations, bool arena,
+                        PARSE_ENGINE engine = ENGINE_RECURSIVE) {
+    size_t allocs = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        Json v;
+        size_t before = alloc_count;
+        check(arena ? v.parse_document(json, engine) : v.parse(json, engine), name);
+        allocs += alloc_count - before;
+    }
+    report(name, "parse", json.size(), iterations, seconds_since(start), allocs);
+}
+
+static void bench_stringify(const string& name, const string& json, size_t iterations) {
+    Json v;
+    v.parse(json);
+    string out;
+    size_t before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        out.clear();
+        v.stringify(out);
+    }
+    report(name, "stringify", out.size(), iterations, seconds_since(start), alloc_count - before);
+}
+
+// every round writes into a new string, which grows as it goes or once with exact_size
+// with fresh a just parsed tree is stringified, so no size is cached in it yet, parsing is not timed
+static void bench_stringify_grow(const string& name, const string& json, size_t iterations, bool exact_size, bool fresh) {
+    Json v;
+    v.parse(json);
+    size_t bytes = 0, allocs = 0;
+    double sec = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        if (fresh) v.parse(json);
+        string out;
+        size_t before = alloc_count;
+        auto start = chrono::steady_clock::now();
+        v.stringify(out, exact_size);
+        sec += seconds_since(start);
+        allocs += alloc_count - before;
+        bytes = out.size();
+    }
+    report(name, "stringify", bytes, iterations, sec, allocs);
+}
+
+// the same through a 64k chunk handed to a callback, the output never exists as one string
+static void bench_stringify_sink(const string& name, const string& json, size_t iterations) {
+    Json v;
+    v.parse(json);
+    size_t bytes = 0, before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        v.stringify([&](const char*, size_t len) { bytes += len; return true; });
+    }
+    report(name, "stringify", bytes / iterations, iterations, seconds_since(start), alloc_count - before);
+}
+
+// read three fields out of a small document, once through a full parse and once through LazyValue
+static void bench_lazy(const string& json, size_t iterations) {
+    double sink = 0;
+    size_t before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        Json v;
+        v.parse(json);
+        sink += v.get_array_element(10).get_object_value("id").get_number();
+        sink += v.get_array_element(75).get_object_value("pos").get_object_value("x").get_number();
+        sink += v.get_array_element(149).get_object_value("score").get_number();
+    }
+    report("records_150 3 fields (dom)", "access", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        LazyValue root(json);
+        double d = 0;
+        root.get_array_element(10).get_object_value("id").get_number(d);
+        sink += d;
+        root.get_array_element(75).get_object_value("pos").get_object_value("x").get_number(d);
+        sink += d;
+        root.get_array_element(149).get_object_value("score").get_number(d);
+        sink += d;
+    }
+    report("records_150 3 fields (lazy)", "access", json.size(), iterations, seconds_since(start), alloc_count - before);
+    if (sink == 0) cerr << "";
+}
+
+// a few fields of some statuses per request, as a handler would read them
+// chained Json accessors, one JsonPointer per field, and one JsonPointerSet for all fields
+static void bench_pointer(const string& json, size_t iterations) {
+    Json j;
+    check(j.parse(json), "tweets_2k");
+    const char* fields[] = {"/user/screen_name", "/user/followers_count", "/retweet_count", "/entities/hashtags/0/text"};
+    vector<JsonPointer> pointers;
+    JsonPointerSet set;
+    for (size_t i = 0; i < 2000; i += 125) {
+        for (const char* field : fields) {
+            pointers.emplace_back("/statuses/" + to_string(i) + field);
+            set.add(pointers.back());
+        }
+    }
+    double sink = 0;
+    size_t before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t n = 0; n < iterations; ++n) {
+        Json statuses = j.get_object_value("statuses");
+        for (size_t i = 0; i < 2000; i += 125) {
+            Json status = statuses.get_array_element(i);
+            Json user = status.get_object_value("user");
+            sink += user.get_object_value("screen_name").get_string_length();
+            sink += user.get_object_value("followers_count").get_number();
+            sink += status.get_object_value("retweet_count").get_number();
+            Json tag = status.get_object_value("entities").get_object_value("hashtags").get_array_element(0);
+            sink += tag.get_object_value("text").get_string_length();
+        }
+    }
+    report("tweets_2k 64 fields (json)", "pointer", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    JsonRef root = j.get_ref();
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t n = 0; n < iterations; ++n) {
+        for (size_t k = 0; k < pointers.size(); k += 4) {
+            sink += pointers[k].resolve(root).get_string().size();
+            sink += pointers[k + 1].resolve(root).get_number();
+            sink += pointers[k + 2].resolve(root).get_number();
+            sink += pointers[k + 3].resolve(root).get_string().size();
+        }
+    }
+    report("tweets_2k 64 fields (pointer)", "pointer", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    vector<JsonRef> out(set.size());
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t n = 0; n < iterations; ++n) {
+        set.resolve(root, out.data());
+        for (size_t k = 0; k < out.size(); k += 4) {
+            sink += out[k].get_string().size() + out[k + 1].get_number() + out[k + 2].get_number() + out[k + 3].get_string().size();
+        }
+    }
+    report("tweets_2k 64 fields (pointer set)", "pointer", json.size(), iterations, seconds_since(start), alloc_count - before);
+    if (sink == 0) cerr << "";
+}
+
+// $.statuses[*].user.screen_name, a full parse and a walk of the tree against selecting while parsing
+static void bench_path(const string& json, size_t iterations) {
+    double sink = 0;
+    size_t before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t n = 0; n < iterations; ++n) {
+        JsonValue v;
+        check(v.parse(json), "tweets_2k");
+        const JsonValue& statuses = v.get_object_value("statuses");
+        for (size_t i = 0; i < statuses.get_array_size(); ++i) {
+            sink += statuses.get_array_element(i).get_object_value("user").get_object_value("screen_name").get_string_length();
+        }
+    }
+    report("tweets_2k screen names (parse + walk)", "path", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    JsonPath path("$.statuses[*].user.screen_name");
+    vector<JsonValue> out;
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        before = alloc_count;
+        AllocCounts tree_before = tracker.get_counts();
+        start = chrono::steady_clock::now();
+        for (size_t n = 0; n < iterations; ++n) {
+            check(path.select(json, out, (PARSE_ENGINE)engine), "tweets_2k");
+            for (const JsonValue& name : out) sink += name.get_string_length();
+        }
+        double sec = seconds_since(start);
+        AllocCounts tree = tracker.get_counts() - tree_before;
+        report(engine == ENGINE_STAGED ? "tweets_2k screen names (select, staged)" : "tweets_2k screen names (select)", "path",
+               json.size(), iterations, sec, alloc_count - before, &tree);
+    }
+    if (sink == 0) cerr << "";
+}
+
+// same text, fed in chunks as if it came from a socket
+static void bench_stream(const string& name, const string& json, size_t iterations, size_t chunk) {
+    size_t allocs = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        JsonValue jv;
+        size_t before = alloc_count;
+        StreamParser p(jv);
+        for (size_t pos = 0; pos < json.size(); pos += chunk) {
+            p.feed(json.data() + pos, min(chunk, json.size() - pos));
+        }
+        check(p.finish(), name);
+        allocs += alloc_count - before;
+    }
+    report(name, "parse", json.size(), iterations, seconds_since(start), allocs);
+}
+
+// the same buffer on 1, 2, 4 ... threads up to cores, which is the number of cores by default
+static void bench_lines(const string& text, size_t iterations, size_t cores) {
+    if (cores == 0) cores = max<size_t>(thread::hardware_concurrency(), 1);
+    vector<LineRecord> records;
+    for (size_t threads = 1; ; threads = min(threads * 2, cores)) {
+        BatchParser batch(threads);
+        size_t before = alloc_count;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            batch.parse_lines(text, records);
+        }
+        double sec = seconds_since(start);
+        // docs are lines here
+        size_t lines = records.size() * iterations;
+        report("ndjson_100k (" + to_string(threads) + " threads)", "parse_lines", text.size() / max<size_t>(records.size(), 1),
+               lines, sec, alloc_count - before);
+        if (threads == cores) break;
+    }
+}
+
+// read the whole file into a string and parse it, against parsing it from the mapping
+static void bench_file(const string& name, const string& json, size_t iterations) {
+    const string path = "json_bench_tmp.json";
+    {
+        ofstream out(path, ios::binary);
+        out << json;
+    }
+    for (int mapped = 0; mapped <= 1; ++mapped) {
+        size_t allocs = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            Json v;
+            size_t before = alloc_count;
+            int ret;
+            if (mapped) {
+                ret = v.parse_file(path);
+            } else {
+                ifstream in(path, ios::binary);
+                ostringstream ss;
+                ss << in.rdbuf();
+                ret = v.parse(ss.str());
+            }
+            check(ret, name);
+            allocs += alloc_count - before;
+        }
+        report(name + (mapped ? " (parse_file)" : " (read + parse)"), "parse", json.size(), iterations,
+               seconds_since(start), allocs);
+    }
+    remove(path.c_str());
+}
+
+// parse() copies every string and key longer than SSO into its own allocation, parse_insitu() only points at them
+// the texts have no escapes, so parsing in place leaves them unchanged and one buffer serves every iteration
+static void bench_insitu(const string& name, const string& json, size_t iterations) {
+    string buf = json;
+    for (int insitu = 0; insitu <= 1; ++insitu) {
+        size_t allocs = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            JsonValue v;
+            size_t before = alloc_count;
+            check(insitu ? v.parse_insitu(&buf[0], buf.size()) : v.parse(json), name);
+            allocs += alloc_count - before;
+        }
+        report(name + (insitu ? " (insitu)" : " (copied)"), "parse", json.size(), iterations, seconds_since(start), allocs);
+    }
+}
+
+// a SAX handler which only sums up the numbers, nothing is built
+struct SumHandler : BaseHandler {
+    double sum = 0;
+    bool on_number(double d) noexcept { sum += d; return true; }
+};
+
+static void bench_handler(const string& name, const string& json, size_t iterations, PARSE_ENGINE engine) {
+    double sink = 0;
+    size_t before = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        SumHandler handler;
+        GenericParser<SumHandler> p(handler, json);
+        check(engine == ENGINE_STAGED ? p.parse_staged() : p.parse(), name);
+        sink += handler.sum;
+    }
+    report(name, "parse", json.size(), iterations, seconds_since(start), alloc_count - before);
+    if (sink == 0) cerr << "";
+}
+
+// read every value of the tree through the accessors, members also by key lookup, return something to keep it alive
+static double walk(const JsonValue& jv) {
+    double sum = 0;
+    switch (jv.get_type()) {
+        case JSON_NUMBER : return jv.get_number();
+        case JSON_STRING : return (double)jv.get_string_length();
+        case JSON_ARRAY :
+            for (size_t i = 0; i < jv.get_array_size(); ++i) sum += walk(jv.get_array_element(i));
+            return sum;
+        case JSON_OBJECT :
+            for (const auto& member : jv.get_object()) sum += walk(jv.get_object_value(member.first));
+            return sum;
+        default :
+            return jv.get_type();
+    }
+}
+
+// the same through JsonRef, which only points into the tree
+static double walk_ref(JsonRef ref) {
+    double sum = 0;
+    switch (ref.get_type()) {
+        case JSON_NUMBER : return ref.get_number();
+        case JSON_STRING : return (double)ref.get_string().size();
+        case JSON_ARRAY :
+            for (JsonRef elem : ref.get_array()) sum += walk_ref(elem);
+            return sum;
+        case JSON_OBJECT :
+            for (auto member : ref.get_object()) sum += walk_ref(ref[member.key]);
+            return sum;
+        default :
+            return ref.get_type();
+    }
+}
+
+// the same through the Json accessors, which return handles sharing the tree, jv only lends its keys since Json can not list them
+static double walk(const Json& j, const JsonValue& jv) {
+    double sum = 0;
+    switch (j.get_type()) {
+        case JSON_NUMBER : return j.get_number();
+        case JSON_STRING : return (double)j.get_string_length();
+        case JSON_ARRAY :
+            for (size_t i = 0; i < j.get_array_size(); ++i) sum += walk(j.get_array_element(i), jv.get_array_element(i));
+            return sum;
+        case JSON_OBJECT :
+            for (const auto& member : jv.get_object()) {
+                string key(member.first.view());
+                sum += walk(j.get_object_value(key), member.second);
+            }
+            return sum;
+        default :
+            return j.get_type();
+    }
+}
+
+// the same operations on every corpus, so builds can be compared corpus by corpus
+static void bench_corpus(const string& name, const string& json, size_t iterations) {
+    size_t allocs = 0;
+    auto start = chrono::steady_clock::now();
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        allocs = 0;
+        AllocCounts tree;
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            JsonValue v;
+            size_t before = alloc_count;
+            AllocCounts tree_before = tracker.get_counts();
+            check(v.parse(json, (PARSE_ENGINE)engine), name);
+            allocs += alloc_count - before;
+            AllocCounts diff = tracker.get_counts() - tree_before;
+            tree.allocs += diff.allocs;
+            tree.bytes += diff.bytes;
+        }
+        report(name, engine == ENGINE_STAGED ? "parse_staged" : "parse", json.size(), iterations, seconds_since(start),
+               allocs, &tree);
+    }
+
+    JsonValue v, copy;
+    check(v.parse(json), name);
+    check(copy.parse(json), name);
+    string out;
+    size_t before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        out.clear();
+        v.stringify(out);
+    }
+    report(name, "stringify", out.size(), iterations, seconds_since(start), alloc_count - before);
+
+    allocs = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        JsonValue tmp;
+        string text;
+        size_t before = alloc_count;
+        check(tmp.parse(json), name);
+        tmp.stringify(text);
+        allocs += alloc_count - before;
+    }
+    report(name, "roundtrip", json.size(), iterations, seconds_since(start), allocs);
+
+    size_t equal = 0;
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        equal += (v == copy);
+    }
+    report(name, "equal", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    double sink = 0;
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += walk(v);
+    }
+    report(name, "access", json.size(), iterations, seconds_since(start), alloc_count - before);
+
+    // every Json accessor returns a new handle, i.e. a shared_ptr copy, keys are copied into strings for the lookup
+    Json j;
+    check(j.parse(json), name);
+    size_t rounds = iterations;
+    before = alloc_count;
+    AllocCounts tree_before = tracker.get_counts();
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        sink += walk(j, v);
+    }
+    double sec = seconds_since(start);
+    AllocCounts tree = tracker.get_counts() - tree_before;
+    report(name, "access_json", json.size(), rounds, sec, alloc_count - before, &tree);
+
+    before = alloc_count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += walk_ref(j.get_ref());
+    }
+    report(name, "access_ref", json.size(), iterations, seconds_since(start), alloc_count - before);
+    if (equal != iterations || sink == 0) cerr << name << ": unexpected result" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    pmr::set_default_resource(&tracker);
+    // json_bench [iterations] [threads] [--json] [--suite], --suite only runs the corpus suite
+    vector<const char*> args;
+    bool suite_only = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--json") json_output = true;
+        else if (arg == "--suite") suite_only = true;
+        else args.push_back(argv[i]);
+    }
+    size_t iterations = args.size() > 0 ? strtoul(args[0], NULL, 10) : 20;
+    size_t cores = args.size() > 1 ? strtoul(args[1], NULL, 10) : 0;
+    if (iterations == 0) iterations = 1;
+
+    // every corpus is generated, so the same build always measures the same bytes
+    string records_10k = make_document(10000), numbers = make_number_document(100000);
+    string pretty = make_pretty_document(10000);
+    bench_corpus("tweets_2k", make_tweets(2000), iterations);
+    bench_corpus("canada", make_canada(40, 2800), iterations);
+    bench_corpus("deep_2k", make_deep(2000, 64), iterations);
+    bench_corpus("escaped_strings_5k", make_escaped_strings(5000), iterations);
+    bench_corpus("records_10k", records_10k, iterations);
+    bench_corpus("numbers_100k", numbers, iterations);
+    bench_lines(make_ndjson(100000), iterations / 4 + 1, cores);
+    if (suite_only) return 0;
+
+    string records_1k = make_document(1000);
+    bench_parse("records_1k", records_1k, iterations, false);
+    bench_parse("records_1k (arena)", records_1k, iterations, true);
+    bench_parse("records_10k (arena)", records_10k, iterations, true);
+    bench_parse("records_10k (arena, staged)", records_10k, iterations, true, ENGINE_STAGED);
+    bench_parse("pretty_10k (staged)", pretty, iterations, false, ENGINE_STAGED);
+    bench_stream("records_10k (stream, 4k chunks)", records_10k, iterations, 4096);
+    bench_stream("numbers_100k (stream, 4k chunks)", numbers, iterations, 4096);
+    bench_handler("records_10k (sax sum)", records_10k, iterations, ENGINE_RECURSIVE);
+    bench_handler("records_10k (sax sum, staged)", records_10k, iterations, ENGINE_STAGED);
+    bench_file("numbers_100k file", numbers, iterations);
+    bench_insitu("pretty_10k", pretty, iterations);
+    bench_lazy(make_document(150), iterations * 50);
+    bench_pointer(make_tweets(2000), iterations * 5000);
+    bench_path(make_tweets(2000), iterations);
+    bench_stringify("pretty_10k", pretty, iterations);
+    bench_stringify_grow("records_10k (new string)", records_10k, iterations, false, false);
+    bench_stringify_grow("records_10k (new string, exact size)", records_10k, iterations, true, false);
+    bench_stringify_grow("records_10k (fresh tree, exact size)", records_10k, iterations, true, true);
+    // mostly strings, so copying the text dominates rather than formatting numbers
+    bench_stringify_grow("tweets_2k (new string)", make_tweets(2000), iterations, false, false);
+    bench_stringify_grow("tweets_2k (new string, exact size)", make_tweets(2000), iterations, true, false);
+    bench_stringify_sink("records_10k (64k chunks)", records_10k, iterations);
+
+    SIMD_LEVEL best = get_simd_level();
+    for (int level = SIMD_SCALAR; level <= best; ++level) {
+        set_simd_level((SIMD_LEVEL)level);
+        const char* names[] = {"pretty_10k (scalar)", "pretty_10k (sse2)", "pretty_10k (avx2)"};
+        bench_parse(names[level], pretty, iterations, false);
+    }
+    set_simd_level(best);
+    return 0;
+}
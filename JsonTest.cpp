@@ -2,7 +2,23 @@
 #include <cstring>
 #include <cstdlib>
 #include <algorithm>    // sort algorithm
+#include <clocale>      // setlocale
+#include <cmath>        // signbit
+#include <random>       // mt19937_64
+#include <fstream>      // ofstream
+#include <cstdio>       // remove, tmpfile
+#include <sstream>      // ostringstream
+#include <thread>
+#include <atomic>
 #include "src/Json.h"
+#include "src/JsonDocument.h"
+#include "src/JsonLazy.h"
+#include "src/JsonParser.h"
+#include "src/JsonSimd.h"
+#include "src/JsonStream.h"
+#include "src/JsonBatch.h"
+#include "src/JsonPointer.h"
+#include "src/JsonPath.h"
 
 // define static variables for test
 static int main_ret = 0;
@@ -12,6 +28,9 @@ static int test_pass = 0;
 using namespace std;
 using namespace myJson;
 
+// main() installs it as the default resource, so every tree allocation of the tests shows up here, see test_alloc()
+static TrackingResource tracker;
+
 // using macro definition for test, notice that \ should be used in contiuing context
 #define EXPECT_EQ_BASE(expect, actual) \
     do { \
@@ -75,6 +94,61 @@ void static test_parse_number() {
     TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
     TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+    /* more than 19 significant digits, leading zeros do not count */
+    TEST_NUMBER(0.1, "0.1000000000000000000000000000000000000001");
+    TEST_NUMBER(123456789012345678901234567890.0, "123456789012345678901234567890");
+    TEST_NUMBER(1.0, "0.00000000000000000000000000000000001e35");
+    TEST_NUMBER(9007199254740993.0, "9007199254740993");  /* 2^53 + 1, halfway, rounds to even */
+    TEST_NUMBER(9007199254740996.0, "9007199254740995");
+    TEST_NUMBER(9007199254740994.0, "9007199254740993.0000000000000000001"); /* just above halfway */
+    TEST_NUMBER(2.2250738585072011e-308, "2.2250738585072011e-308");
+    TEST_NUMBER(1.7976931348623157e+308, "1.7976931348623158e+308");  /* rounds down to max double */
+    TEST_NUMBER(5e-324, "2.4703282292062328e-324");  /* just above half of minimum denormal */
+    TEST_NUMBER(0.0, "2.4703282292062327e-324");
+    TEST_NUMBER(0.0, "1e-400");
+    TEST_NUMBER(1e23, "1e23");
+    TEST_NUMBER(8.589973e9, "8589973000");
+    TEST_NUMBER(7.0420557077594588e+66, "7.0420557077594588e66");
+    TEST_NUMBER(0.0, "0e99999999999999999999");
+
+    Json v;
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("-0"));
+    EXPECT_EQ_BASE(true, signbit(v.get_number()));
+}
+
+// compare with strtod on random doubles and random digit strings, every result must be correctly rounded
+static void test_parse_number_exact() {
+    mt19937_64 rng(42);
+    char buf[64];
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t bits = rng();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (!isfinite(d)) continue;
+        // fewer digits may round up to infinity, which is PARSE_NUMBER_TOO_BIG
+        snprintf(buf, sizeof(buf), "%.*g", (int)(rng() % 17) + 1, d);
+        double expect = strtod(buf, NULL);
+        if (isinf(expect)) continue;
+        TEST_NUMBER(expect, buf);
+    }
+    for (int i = 0; i < 5000; ++i) {
+        string json = to_string(rng() % 10);
+        size_t digits = rng() % 40;
+        if (digits > 0) json += ".";
+        for (size_t j = 0; j < digits; ++j) json += (char)('0' + rng() % 10);
+        json += "e" + to_string((int)(rng() % 700) - 350);
+        double expect = strtod(json.c_str(), NULL);
+        if (isinf(expect)) continue;
+        TEST_NUMBER(expect, json);
+    }
+
+    // strtod reads "1,5" in a locale with decimal comma, the parser must not care
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL) {
+        TEST_NUMBER(1.5, "1.5");
+        TEST_NUMBER(-3.25e-2, "-3.25e-2");
+        setlocale(LC_NUMERIC, "C");
+    }
 }
 
 #define TEST_STRING(expect, json) \
@@ -82,7 +156,7 @@ void static test_parse_number() {
         Json v; \
         EXPECT_EQ_BASE(PARSE_OK, v.parse(json)); \
         EXPECT_EQ_BASE(JSON_STRING, v.get_type()); \
-        EXPECT_EQ_BASE(0, memcmp((expect), v.get_string().c_str(), v.get_string_length())); \
+        EXPECT_EQ_BASE(0, memcmp((expect), v.get_string().data(), v.get_string_length())); \
     } while(0)
 
 static void test_parse_string() {
@@ -185,11 +259,25 @@ static void test_parse_object() {
     }
 }
 
+// feed json to a StreamParser in chunks of chunk bytes
+static int stream_parse(JsonValue& jv, const string& json, size_t chunk) {
+    StreamParser p(jv);
+    for (size_t i = 0; i < json.size(); i += chunk) {
+        p.feed(json.data() + i, min(chunk, json.size() - i));
+    }
+    return p.finish();
+}
+
 #define TEST_PARSE_ERROR(error, json) \
     do { \
         Json v; \
         EXPECT_EQ_BASE((error), v.parse(json)); \
         EXPECT_EQ_BASE(JSON_NULL, v.get_type()); \
+        EXPECT_EQ_BASE((error), v.parse(json, ENGINE_STAGED)); \
+        EXPECT_EQ_BASE(JSON_NULL, v.get_type()); \
+        JsonValue jv; \
+        EXPECT_EQ_BASE((error), stream_parse(jv, json, 1)); \
+        EXPECT_EQ_BASE(JSON_NULL, jv.get_type()); \
     } while(0)
 
 static void test_parse_expect_value() {
@@ -301,9 +389,440 @@ static void test_parse_miss_comma_or_curly_bracket() {
     TEST_PARSE_ERROR(PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 }
 
+// long whitespace runs and strings cross the 16/32 byte blocks of SIMD kernels at every offset
+static void test_parse_simd() {
+    SIMD_LEVEL best = get_simd_level();
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; ++level) {
+        set_simd_level((SIMD_LEVEL)level);
+        for (size_t n = 0; n < 70; ++n) {
+            string ws(n, ' '), plain(n, 'a');
+            for (size_t i = 0; i < n; ++i) {
+                ws[i] = " \t\n\r"[i % 4];
+                plain[i] = (char)('a' + i % 26);
+            }
+            Json v;
+            EXPECT_EQ_BASE(PARSE_OK, v.parse(ws + "[" + ws + "\"" + plain + "\\n" + plain + "\"" + ws + "]" + ws));
+            string expect = plain + "\n" + plain;
+            EXPECT_EQ_BASE(string_view(expect), v.get_array_element(0).get_string());
+            EXPECT_EQ_BASE(PARSE_OK, v.parse("\"" + plain + "\xE2\x82\xAC" + plain + "\""));
+            expect = plain + "\xE2\x82\xAC" + plain;
+            EXPECT_EQ_BASE(string_view(expect), v.get_string());
+            EXPECT_EQ_BASE(PARSE_INVALID_STRING_CHAR, v.parse("\"" + plain + "\x1F" + plain + "\""));
+            EXPECT_EQ_BASE(PARSE_MISS_QUOTATION_MARK, v.parse("\"" + plain));
+            EXPECT_EQ_BASE(PARSE_ROOT_NOT_SINGULAR, v.parse("1" + ws + "x"));
+        }
+    }
+    set_simd_level(best);
+}
+
+// both engines and the stream parser must agree on the result and the tree, on every SIMD level
+static void test_parse_engines(const string& json) {
+    Json v1, v2;
+    int ret = v1.parse(json);
+    EXPECT_EQ_BASE(ret, v2.parse(json, ENGINE_STAGED));
+    string json1, json2;
+    v1.stringify(json1);
+    v2.stringify(json2);
+    EXPECT_EQ_BASE(json1, json2);
+    // bytes behind the end of a view must never change the result
+    string padded = json + "\"1]";
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        Json v3;
+        EXPECT_EQ_BASE(ret, v3.parse(string_view(padded.data(), json.size()), (PARSE_ENGINE)engine));
+        string json3;
+        v3.stringify(json3);
+        EXPECT_EQ_BASE(json1, json3);
+    }
+    for (size_t chunk : {(size_t)1, (size_t)7}) {
+        JsonValue jv;
+        EXPECT_EQ_BASE(ret, stream_parse(jv, json, chunk));
+        string json3;
+        jv.stringify(json3);
+        EXPECT_EQ_BASE(json1, json3);
+    }
+}
+
+static void test_parse_view() {
+    Json v;
+    // views into a larger buffer, the text behind them would change the result if it were read
+    string buf = "xx[1, 2]yy";
+    EXPECT_EQ_BASE(PARSE_OK, v.parse(string_view(buf).substr(2, 6)));
+    EXPECT_EQ_BASE(2, v.get_array_size());
+    EXPECT_EQ_BASE(PARSE_OK, v.parse(buf.data() + 2, 6, ENGINE_STAGED));
+    EXPECT_EQ_BASE(2, v.get_array_size());
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("truex", 4));
+    EXPECT_EQ_BASE(JSON_TRUE, v.get_type());
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("1.5e3", 3));
+    EXPECT_EQ_BASE(1.5, v.get_number());
+
+    // every token cut by the end of the view
+    struct {
+        int error;
+        const char* json;
+        size_t len;
+    } cuts[] = {
+        {PARSE_EXPECT_VALUE, "1", 0},
+        {PARSE_INVALID_VALUE, "null", 3},
+        {PARSE_INVALID_VALUE, "false", 1},
+        {PARSE_INVALID_VALUE, "1.5", 2},
+        {PARSE_INVALID_VALUE, "1e5", 2},
+        {PARSE_INVALID_VALUE, "-1", 1},
+        {PARSE_MISS_QUOTATION_MARK, "\"abc\"", 4},
+        {PARSE_MISS_QUOTATION_MARK, "\"a\\nb\"", 5},
+        {PARSE_INVALID_STRING_ESCAPE, "\"\\n\"", 2},
+        {PARSE_INVALID_UNICODE_HEX, "\"\\u1234\"", 5},
+        {PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 7},
+        {PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 8},
+        {PARSE_INVALID_UNICODE_HEX, "\"\\uD834\\uDD1E\"", 12},
+        {PARSE_EXPECT_VALUE, "[1]", 1},
+        {PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1]", 2},
+        {PARSE_EXPECT_VALUE, "[1,2]", 3},
+        {PARSE_MISS_KEY, "{}", 1},
+        {PARSE_MISS_COLON, "{\"a\":1}", 4},
+        {PARSE_EXPECT_VALUE, "{\"a\":1}", 5},
+        {PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1}", 6},
+    };
+    for (const auto& cut : cuts) {
+        for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+            EXPECT_EQ_BASE(cut.error, v.parse(cut.json, cut.len, (PARSE_ENGINE)engine));
+        }
+        JsonValue jv;
+        EXPECT_EQ_BASE(cut.error, stream_parse(jv, string(cut.json, cut.len), 1));
+    }
+
+    // a raw '\0' is a control char like others, only \u0000 puts one into a string
+    string nul[] = {string("\"a\0b\"", 5), string("[1]\0", 4), string("[\0]", 3), string("\0", 1)};
+    int errors[] = {PARSE_INVALID_STRING_CHAR, PARSE_ROOT_NOT_SINGULAR, PARSE_INVALID_VALUE, PARSE_INVALID_VALUE};
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ_BASE(errors[i], v.parse(nul[i]));
+        EXPECT_EQ_BASE(errors[i], v.parse(nul[i], ENGINE_STAGED));
+    }
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("[\"a\\u0000b\", 1]"));
+    EXPECT_EQ_BASE(3, v.get_array_element(0).get_string_length());
+    EXPECT_EQ_BASE(string_view("a\0b", 3), v.get_array_element(0).get_string());
+}
+
+static void test_parse_staged() {
+    // escapes, backslash runs and quotes crossing the 64 byte blocks of stage 1 at every offset
+    vector<string> docs;
+    for (size_t n = 0; n < 140; ++n) {
+        string pad(n, ' ');
+        docs.push_back(pad + "[\"" + string(n % 7, 'a') + "\\\\\", \"\\\"\", {\"k\\\\\\\"\" : [1, -2.5e3, true]}]");
+        docs.push_back("{\"" + string(n, 'x') + "\\\"\":\"" + string(n % 5 * 2, '\\') + "\", \"b\" : null}");
+        docs.push_back("[" + pad + "123" + pad + "," + pad + "\"" + pad + "\"" + pad + "]" + pad);
+    }
+    docs.push_back("{\"a\":[1,2,{\"b\":[[],{}]}],\"c\":\"\\u20AC\\uD834\\uDD1E\",\"d\":false}");
+
+    mt19937_64 rng(1);
+    const char alphabet[] = "{}[]:,\"\\ \n0123456789.eE+-truefalsn\x01\0";
+    SIMD_LEVEL best = get_simd_level();
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; ++level) {
+        set_simd_level((SIMD_LEVEL)level);
+        for (const auto& doc : docs) {
+            Json v;
+            EXPECT_EQ_BASE(PARSE_OK, v.parse(doc, ENGINE_STAGED));
+            test_parse_engines(doc);
+        }
+        // random edits mostly produce invalid texts, the staged engine has to reject exactly the same ones
+        for (int i = 0; i < 3000; ++i) {
+            string doc = docs[rng() % docs.size()];
+            for (int edits = rng() % 3 + 1; edits > 0; --edits) {
+                size_t pos = rng() % doc.size();
+                char ch = alphabet[rng() % (sizeof(alphabet) - 1)];
+                switch (rng() % 3) {
+                    case 0 : doc[pos] = ch; break;
+                    case 1 : doc.insert(doc.begin() + pos, ch); break;
+                    default : doc.erase(pos, 1); break;
+                }
+                if (doc.empty()) doc = " ";
+            }
+            test_parse_engines(doc);
+        }
+    }
+    set_simd_level(best);
+}
+
+// records every event as one char, keys and strings are written out
+struct TraceHandler : BaseHandler {
+    string trace;
+    int numbers_left = -1;
+    bool on_null() noexcept { trace += 'n'; return true; }
+    bool on_bool(bool b) noexcept { trace += b ? 't' : 'f'; return true; }
+    bool on_number(double d) noexcept { trace += to_string((int)d); return --numbers_left != 0; }
+    bool on_string(string_view str) noexcept { trace += "s("; trace += str; trace += ')'; return true; }
+    bool on_start_array() noexcept { trace += '['; return true; }
+    bool on_end_array(size_t count) noexcept { trace += ']' + to_string(count); return true; }
+    bool on_start_object() noexcept { trace += '{'; return true; }
+    bool on_key(string_view key) noexcept { trace += "k("; trace += key; trace += ')'; return true; }
+    bool on_end_object(size_t count) noexcept { trace += '}' + to_string(count); return true; }
+};
+
+// only counts numbers and sums them, nothing else is overridden
+struct SumHandler : BaseHandler {
+    size_t count = 0;
+    double sum = 0;
+    bool on_number(double d) noexcept { ++count; sum += d; return true; }
+};
+
+static void test_parse_handler() {
+    string json = " { \"a\" : [ 1, true, false, null, \"x\\ty\" ], \"b\\u0041\" : { }, \"c\" : [ ], \"d\" : 2 } ";
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        TraceHandler trace;
+        GenericParser<TraceHandler> p(trace, json);
+        EXPECT_EQ_BASE(PARSE_OK, (engine == ENGINE_STAGED ? p.parse_staged() : p.parse()));
+        EXPECT_EQ_BASE("{k(a)[1tfns(x\ty)]5k(bA){}0k(c)[]0k(d)2}4", trace.trace);
+
+        // returning false stops at once
+        TraceHandler abort;
+        abort.numbers_left = 2;
+        string json2 = "[1, [2, 3], 4]";
+        GenericParser<TraceHandler> p2(abort, json2);
+        EXPECT_EQ_BASE(PARSE_ABORTED, (engine == ENGINE_STAGED ? p2.parse_staged() : p2.parse()));
+        EXPECT_EQ_BASE("[1[2", abort.trace);
+
+        SumHandler sum;
+        string json3 = "{\"x\":[1.5, {\"y\":-0.5}], \"z\":\"3\", \"w\":10}";
+        GenericParser<SumHandler> p3(sum, json3);
+        EXPECT_EQ_BASE(PARSE_OK, (engine == ENGINE_STAGED ? p3.parse_staged() : p3.parse()));
+        EXPECT_EQ_BASE(3, sum.count);
+        EXPECT_EQ_BASE(11.0, sum.sum);
+
+        // errors are the same as the ones of the DOM parser
+        BaseHandler base;
+        string json4 = "[1, 2";
+        GenericParser<BaseHandler> p4(base, json4);
+        EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, (engine == ENGINE_STAGED ? p4.parse_staged() : p4.parse()));
+    }
+}
+
+static void test_parse_stream() {
+    const char* docs[] = {
+        "  { \"a\" : [ 1, -0, 0.5, -12.25e-3, 1E+2, 123456789012345678901234567890, true, false, null ] ,"
+        " \"b\\u0041\" : { \"\" : \"x\\\"\\\\\\/\\b\\f\\n\\r\\ty\" }, \"c\" : \"\\u20AC\\uD834\\uDD1E\\u00e9\" } ",
+        "[[[]], {}, [{}], \"\", 0]",
+        "-1.5e300",
+        "\"abc\"",
+        "1e400",
+        "[1, 2",
+        "{\"a\" 1}",
+    };
+    // cut every text into two chunks at every position
+    for (const char* doc : docs) {
+        string json = doc;
+        Json v;
+        int ret = v.parse(json);
+        string expect;
+        v.stringify(expect);
+        for (size_t cut = 0; cut <= json.size(); ++cut) {
+            JsonValue jv;
+            StreamParser p(jv);
+            p.feed(json.data(), cut);
+            p.feed(json.data() + cut, json.size() - cut);
+            EXPECT_EQ_BASE(ret, p.finish());
+            string actual;
+            jv.stringify(actual);
+            EXPECT_EQ_BASE(expect, actual);
+        }
+    }
+
+    // same events as GenericParser, whatever the chunks are
+    string json = " { \"a\" : [ 1, true, false, null, \"x\\ty\" ], \"b\\u0041\" : { }, \"c\" : [ ], \"d\" : 2 } ";
+    for (size_t chunk = 1; chunk <= json.size(); ++chunk) {
+        TraceHandler trace;
+        GenericStreamParser<TraceHandler> p(trace);
+        for (size_t i = 0; i < json.size(); i += chunk) {
+            EXPECT_EQ_BASE(PARSE_OK, p.feed(json.data() + i, min(chunk, json.size() - i)));
+        }
+        EXPECT_EQ_BASE(PARSE_OK, p.finish());
+        EXPECT_EQ_BASE("{k(a)[1tfns(x\ty)]5k(bA){}0k(c)[]0k(d)2}4", trace.trace);
+    }
+
+    // the first error is found as soon as its byte arrives, and kept
+    JsonValue jv;
+    StreamParser p1(jv);
+    EXPECT_EQ_BASE(PARSE_OK, p1.feed("[1, ", 4));
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, p1.feed("]", 1));
+    EXPECT_EQ_BASE(JSON_NULL, jv.get_type());
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, p1.feed("2]", 2));
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, p1.finish());
+
+    // a raw '\0' is an invalid byte like in parse()
+    StreamParser p2(jv);
+    EXPECT_EQ_BASE(PARSE_OK, p2.feed("[1]", 3));
+    EXPECT_EQ_BASE(PARSE_ROOT_NOT_SINGULAR, p2.feed("\0", 1));
+    EXPECT_EQ_BASE(JSON_NULL, jv.get_type());
+
+    // a number is only complete when the text ends
+    StreamParser p3(jv);
+    EXPECT_EQ_BASE(PARSE_OK, p3.feed("12", 2));
+    EXPECT_EQ_BASE(PARSE_OK, p3.feed("3.", 2));
+    EXPECT_EQ_BASE(PARSE_OK, p3.feed("5", 1));
+    EXPECT_EQ_BASE(PARSE_OK, p3.finish());
+    EXPECT_EQ_BASE(123.5, jv.get_number());
+    StreamParser p4(jv);
+    EXPECT_EQ_BASE(PARSE_OK, p4.feed("12.", 3));
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, p4.finish());
+}
+
+static void test_parse_lines() {
+    string text = "{\"a\":1}\n\n  \r\n[1, 2]\r\n\"x\ny\"\ntrue   \n{\"b\":[]}";
+    for (size_t threads : {1, 2, 4}) {
+        BatchParser batch(threads);
+        EXPECT_EQ_BASE(threads, batch.get_thread_count());
+        vector<LineRecord> records;
+        batch.parse_lines(text, records);
+        // blank lines are skipped, a raw '\n' inside a string splits it into two invalid lines
+        EXPECT_EQ_BASE(6, records.size());
+        size_t lines[] = {1, 4, 5, 6, 7, 8};
+        int rets[] = {PARSE_OK, PARSE_OK, PARSE_MISS_QUOTATION_MARK, PARSE_INVALID_VALUE, PARSE_OK, PARSE_OK};
+        for (size_t i = 0; i < records.size() && i < 6; ++i) {
+            EXPECT_EQ_BASE(lines[i], records[i].line);
+            EXPECT_EQ_BASE(rets[i], records[i].ret);
+        }
+        EXPECT_EQ_BASE(JSON_OBJECT, records[0].value.get_type());
+        EXPECT_EQ_BASE(2, records[1].value.get_array_size());
+        EXPECT_EQ_BASE(JSON_NULL, records[2].value.get_type());
+        EXPECT_EQ_BASE(JSON_TRUE, records[4].value.get_type());
+
+        batch.parse_lines("", records);
+        EXPECT_EQ_BASE(0, records.size());
+        batch.parse_lines("\n \n", records);
+        EXPECT_EQ_BASE(0, records.size());
+    }
+
+    // many blocks, every record must match a plain parse of its line, on every engine
+    mt19937_64 rng(3);
+    string big;
+    vector<string> lines;
+    for (size_t i = 0; i < 5000; ++i) {
+        string line;
+        switch (rng() % 4) {
+            case 0 : line = "{\"id\":" + to_string(i) + ",\"tags\":[\"a\",\"b\\u00e9\"],\"ok\":true}"; break;
+            case 1 : line = "[" + to_string(rng() % 1000) + ".5, null, {\"k\":{}}]"; break;
+            case 2 : line = "{\"id\":" + to_string(i) + ", }"; break;
+            default : line = string(rng() % 200, ' ') + "\"" + string(rng() % 300, 'x') + "\""; break;
+        }
+        lines.push_back(line);
+        big += line + "\n";
+    }
+    BatchParser batch(4);
+    vector<LineRecord> records;
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        batch.parse_lines(big, records, (PARSE_ENGINE)engine);
+        EXPECT_EQ_BASE(lines.size(), records.size());
+        for (size_t i = 0; i < records.size() && i < lines.size(); ++i) {
+            Json v;
+            EXPECT_EQ_BASE(i + 1, records[i].line);
+            EXPECT_EQ_BASE(v.parse(lines[i]), records[i].ret);
+            string expect, actual;
+            v.stringify(expect);
+            records[i].value.stringify(actual);
+            EXPECT_EQ_BASE(expect, actual);
+        }
+    }
+}
+
+static void write_file(const string& path, const string& text) {
+    ofstream out(path, ios::binary);
+    out << text;
+}
+
+static void test_parse_file() {
+    const string path = "myJson_test_parse_file.json";
+    // a file of whole pages ends right at the end of its mapping, reading one byte behind it would crash
+    for (size_t size : {(size_t)1, (size_t)100, (size_t)4095, (size_t)4096, (size_t)4097, (size_t)65536}) {
+        string json = "[1, \"abc\", {\"k\": null}]";
+        json = size >= json.size() ? json + string(size - json.size(), ' ') : "1";
+        write_file(path, json);
+        for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+            Json v1, v2;
+            EXPECT_EQ_BASE(PARSE_OK, v1.parse_file(path, (PARSE_ENGINE)engine));
+            v2.parse(json);
+            EXPECT_EQ_BASE(true, (v1 == v2));
+        }
+    }
+    Json v;
+    write_file(path, string(4096, ' '));
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, v.parse_file(path));
+    write_file(path, "");
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, v.parse_file(path));
+    write_file(path, "{\"a\": [1, 2");
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, v.parse_file(path, ENGINE_STAGED));
+    EXPECT_EQ_BASE(JSON_NULL, v.get_type());
+    remove(path.c_str());
+
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("true"));
+    EXPECT_EQ_BASE(PARSE_FILE_ERROR, v.parse_file(path));
+    EXPECT_EQ_BASE(JSON_NULL, v.get_type());
+}
+
+static bool points_into(string_view str, const string& buf) {
+    return str.data() >= buf.data() && str.data() + str.size() <= buf.data() + buf.size();
+}
+
+static void test_parse_insitu() {
+    string buf = "{\"plain\": \"abc\", \"esc\\taped\": \"a\\n\\u00e9\\uD834\\uDD1E\", \"list\": [\"x\", \"\", 1]}";
+    string text = buf;
+    JsonValue v, expect;
+    EXPECT_EQ_BASE(PARSE_OK, v.parse_insitu(&buf[0], buf.size()));
+    EXPECT_EQ_BASE(PARSE_OK, expect.parse(text));
+    EXPECT_EQ_BASE(true, (v == expect));
+    EXPECT_EQ_BASE("abc", v.get_object_value("plain").get_string());
+    EXPECT_EQ_BASE("a\n\xC3\xA9\xF0\x9D\x84\x9E", v.get_object_value("esc\taped").get_string());
+    // plain and decoded strings and keys all live inside buf
+    EXPECT_EQ_BASE(true, points_into(v.get_object_value("plain").get_string(), buf));
+    EXPECT_EQ_BASE(true, points_into(v.get_object_value("esc\taped").get_string(), buf));
+    EXPECT_EQ_BASE(true, points_into(v.get_object_value("list").get_array_element(0).get_string(), buf));
+    for (const auto& member : v.get_object()) {
+        EXPECT_EQ_BASE(true, points_into(member.first, buf));
+    }
+
+    // copies own their strings, moves still point into buf
+    JsonValue copy(v), moved(std::move(v));
+    EXPECT_EQ_BASE(true, points_into(moved.get_object_value("plain").get_string(), buf));
+    EXPECT_EQ_BASE(false, points_into(copy.get_object_value("plain").get_string(), buf));
+    string saved = buf;
+    buf.replace(0, buf.size(), buf.size(), '#');
+    EXPECT_EQ_BASE(true, (copy == expect));
+    buf = saved;
+    EXPECT_EQ_BASE(true, (moved == expect));
+
+    // changing a borrowed value or adding keys copies only the new chars
+    JsonValue s;
+    string str = "\"view\"";
+    EXPECT_EQ_BASE(PARSE_OK, s.parse_insitu(&str[0], str.size()));
+    s.set_string("owned");
+    EXPECT_EQ_BASE("owned", s.get_string());
+    EXPECT_EQ_BASE("\"view\"", str);
+    moved.set_object_value("new", s);
+    EXPECT_EQ_BASE(4, (int)moved.get_object_size());
+    EXPECT_EQ_BASE("owned", moved.get_object_value("new").get_string());
+
+    // past INDEX_THRESHOLD borrowed keys are hashed like owned ones
+    string big = "{";
+    for (int i = 0; i < 40; ++i) big += (i ? ",\"k" : "\"k") + to_string(i) + "\":" + to_string(i);
+    big += "}";
+    Document doc;
+    EXPECT_EQ_BASE(PARSE_OK, doc.parse_insitu(&big[0], big.size()));
+    EXPECT_EQ_BASE(40, (int)doc.get_root().get_object_size());
+    EXPECT_EQ_BASE(true, doc.get_root().find_object_key("k39"));
+    EXPECT_EQ_BASE(7.0, doc.get_root().get_object_value("k7").get_number());
+    doc.get_root().remove_object_value("k0");
+    EXPECT_EQ_BASE(true, doc.get_root().find_object_key("k39"));
+
+    // errors are the same as parse(), and the value is reset to null
+    for (const char* json : {"[\"a\\n\", ", "{\"a\\u0041\" 1}", "\"\\uD800\"", "[1] x", "\"abc"}) {
+        Json j;
+        string copy_json = json;
+        EXPECT_EQ_BASE(j.parse(json), j.parse_insitu(&copy_json[0], copy_json.size()));
+        EXPECT_EQ_BASE(JSON_NULL, j.get_type());
+    }
+}
+
 static void test_parse() {
     test_parse_literal();
     test_parse_number();
+    test_parse_number_exact();
     test_parse_string();
     test_parse_array();
     test_parse_object();
@@ -321,6 +840,14 @@ static void test_parse() {
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_parse_simd();
+    test_parse_staged();
+    test_parse_view();
+    test_parse_handler();
+    test_parse_stream();
+    test_parse_lines();
+    test_parse_file();
+    test_parse_insitu();
 }
 
 // use roundtrip to test stringify function
@@ -331,6 +858,7 @@ static void test_parse() {
         string json2; \
         v.stringify(json2); \
         EXPECT_EQ_BASE((json), (json2)); \
+        EXPECT_EQ_BASE(json2.size(), v.get_stringify_size()); \
     } while(0)
 
 static void test_stringify_number() {
@@ -346,14 +874,83 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1.234e-20");
 
     TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+    /* shortest digits, same layout as %.17g */
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.3");
+    TEST_ROUNDTRIP("123.456");
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1.5e-05");
+    TEST_ROUNDTRIP("9007199254740991");
+    TEST_ROUNDTRIP("9007199254740992");
+    TEST_ROUNDTRIP("10000000000000000");
+    TEST_ROUNDTRIP("1e+17");
+    TEST_ROUNDTRIP("5e+22");
+    TEST_ROUNDTRIP("1.2345678901234567e-100");
+    TEST_ROUNDTRIP("8.98846567431158e+307"); /* 2^1023, lower neighbour is closer */
+
+    Json v;
+    string json;
+    v.set_number(0.1 + 0.2);
+    v.stringify(json);
+    EXPECT_EQ_BASE("0.30000000000000004", json);
+    v.set_number(4.9406564584124654e-324);
+    json.clear();
+    v.stringify(json);
+    EXPECT_EQ_BASE("5e-324", json);
+}
+
+// random doubles must parse back to exactly the same bits
+static void test_stringify_number_roundtrip() {
+    mt19937_64 rng(7);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t bits = rng();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (!isfinite(d)) continue;
+        Json v, v2;
+        v.set_number(d);
+        string json;
+        v.stringify(json);
+        EXPECT_EQ_BASE(PARSE_OK, v2.parse(json));
+        double d2 = v2.get_number();
+        EXPECT_EQ_BASE(0, memcmp(&d, &d2, sizeof(d)));
+        EXPECT_EQ_BASE(true, (json.size() <= 24));
+    }
+}
+
+// json has no NaN or infinity, they are written as null by every stringify path, and sized as such
+static void test_stringify_nonfinite() {
+    for (double d : {(double)NAN, HUGE_VAL, -HUGE_VAL}) {
+        Json v;
+        v.set_number(d);
+        string json;
+        v.stringify(json);
+        EXPECT_EQ_BASE("null", json);
+        EXPECT_EQ_BASE(4, v.get_stringify_size());
+
+        Json arr;
+        arr.set_array();
+        arr.pushback_array_element(v);
+        Json one;
+        one.set_number(1);
+        arr.pushback_array_element(one);
+        json.clear();
+        arr.stringify(json, true);
+        EXPECT_EQ_BASE("[null,1]", json);
+        EXPECT_EQ_BASE(json.size(), arr.get_stringify_size());
+        ostringstream os;
+        EXPECT_EQ_BASE(true, arr.stringify(os));
+        EXPECT_EQ_BASE("[null,1]", os.str());
+    }
 }
 
 static void test_stringify_string() {
@@ -362,6 +959,37 @@ static void test_stringify_string() {
     TEST_ROUNDTRIP("\"Hello\\nWorld\"");
     TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
     TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_ROUNDTRIP("\"\\u0001\\u000B\\u001F\xC3\xA9\xF0\x9D\x84\x9E\"");
+
+    // every char which needs escaping at every position of short and long strings, i.e. on both sides of the SIMD path
+    for (size_t len : {(size_t)5, (size_t)15, (size_t)16, (size_t)40, (size_t)100}) {
+        for (size_t pos = 0; pos < len; ++pos) {
+            for (int ch = 0; ch <= 0x5C; ++ch) {
+                if (ch >= 0x20 && ch != '\"' && ch != '\\') continue;
+                string str(len, 'a');
+                str[pos] = (char)ch;
+                if (pos + 1 < len) str[pos + 1] = (char)0xC3;
+                Json v;
+                v.set_string(str);
+                string json, expect = "\"" + str.substr(0, pos);
+                const char* shorts = "btn\0fr";
+                if (ch == '\"' || ch == '\\') {
+                    expect += '\\';
+                    expect += (char)ch;
+                } else if (ch >= '\b' && ch <= '\r' && ch != 0x0B) {
+                    expect += '\\';
+                    expect += shorts[ch - '\b'];
+                } else {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04X", ch);
+                    expect += buf;
+                }
+                expect += str.substr(pos + 1) + "\"";
+                v.stringify(json);
+                EXPECT_EQ_BASE(expect, json);
+            }
+        }
+    }
 }
 
 static void test_stringify_array() {
@@ -371,17 +999,190 @@ static void test_stringify_array() {
 
 static void test_stringify_object() {
     TEST_ROUNDTRIP("{}");
+    // JSON_OBJECT keeps members in insertion order now, so the output equals input exactly
+    TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+}
+
+static string read_all(FILE* file) {
+    string res;
+    char buf[4096];
+    rewind(file);
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), file)) > 0; ) res.append(buf, n);
+    return res;
+}
 
-    // since map data structure doesn't remain original sequence as input, TEST_ROUNDTRIP doesn't work here
-    // instead, we use simple cmp method here, after TEST_ROUNDTRIP, sort two jsons then cmp them
-    string json1 = "{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}";
+static void test_stringify_sink() {
+    string json = "[";
+    for (int i = 0; i < 2000; ++i) {
+        json += (i ? "," : "") + string("{\"id\":") + to_string(i) + ",\"s\":\"a\\tb\\u0001\xC3\xA9\",\"n\":[1.5,null,true]}";
+    }
+    json += "]";
     Json v;
-    EXPECT_EQ_BASE(PARSE_OK, v.parse(json1));
-    string json2;
-    v.stringify(json2);
-    sort(json1.begin(), json1.end());
-    sort(json2.begin(), json2.end());
-    EXPECT_EQ_BASE(json1, json2);
+    EXPECT_EQ_BASE(PARSE_OK, v.parse(json));
+    string expect;
+    v.stringify(expect);
+    EXPECT_EQ_BASE(json, expect);
+
+    // appending keeps what was in the string before
+    string str = "prefix";
+    v.stringify(str);
+    EXPECT_EQ_BASE("prefix" + expect, str);
+
+    ostringstream os;
+    EXPECT_EQ_BASE(true, v.stringify(os));
+    EXPECT_EQ_BASE(expect, os.str());
+
+    FILE* file = tmpfile();
+    EXPECT_EQ_BASE(true, v.stringify(file));
+    EXPECT_EQ_BASE(expect, read_all(file));
+    fclose(file);
+
+    file = tmpfile();
+    EXPECT_EQ_BASE(true, v.stringify(fileno(file)));
+    EXPECT_EQ_BASE(expect, read_all(file));
+    fclose(file);
+
+    // a tiny chunk is flushed many times, no chunk is ever larger than it
+    string chunks;
+    size_t calls = 0, largest = 0;
+    CallbackSink sink([&](const char* data, size_t len) {
+        chunks.append(data, len);
+        ++calls;
+        largest = max(largest, len);
+        return true;
+    }, 100);
+    EXPECT_EQ_BASE(true, v.stringify(sink));
+    EXPECT_EQ_BASE(expect, chunks);
+    EXPECT_EQ_BASE(true, (calls > expect.size() / 100));
+    EXPECT_EQ_BASE(true, (largest <= 100));
+
+    // after a failed write nothing more is written and every later flush reports it
+    calls = 0;
+    CallbackSink failing([&](const char*, size_t) { ++calls; return false; }, 100);
+    EXPECT_EQ_BASE(false, v.stringify(failing));
+    EXPECT_EQ_BASE(1, (int)calls);
+    EXPECT_EQ_BASE(false, failing.flush());
+    EXPECT_EQ_BASE(false, v.stringify(-1));
+}
+
+static void expect_size(const JsonValue& v) {
+    string json;
+    v.stringify(json);
+    EXPECT_EQ_BASE(json.size(), v.get_stringify_size());
+}
+
+static void test_stringify_size() {
+    JsonValue v;
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("{\"a\":[1,2.5,-1e300,\"x\\u0001\\n\"],\"b\\t\":{\"c\":null,\"d\":[]},\"e\":{}}"));
+    expect_size(v);
+    // every change drops the cached size of the changed value, its untouched children keep theirs
+    JsonValue elem;
+    elem.set_string("\"quoted\"");
+    v.set_object_value("f", elem);
+    expect_size(v);
+    v.remove_object_value("a");
+    expect_size(v);
+    JsonValue arr;
+    EXPECT_EQ_BASE(PARSE_OK, arr.parse("[true,false]"));
+    expect_size(arr);
+    arr.pushback_array_element(elem);
+    expect_size(arr);
+    arr.insert_array_element(0, v);
+    expect_size(arr);
+    arr.erase_array_element(1, 2);
+    expect_size(arr);
+    arr.popback_array_element();
+    expect_size(arr);
+    arr.clear_array();
+    expect_size(arr);
+    JsonValue copy(v), moved(std::move(copy));
+    EXPECT_EQ_BASE(v.get_stringify_size(), moved.get_stringify_size());
+    v.set_number(0.1);
+    expect_size(v);
+    v.set_string("\x01");
+    expect_size(v);
+    v.set_type(JSON_FALSE);
+    expect_size(v);
+
+    // with exact_size the string grows once to the exact size
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("[\"a long string which does not fit into the small buffer of a string\", 12345.678]"));
+    string json;
+    v.stringify(json, true);
+    EXPECT_EQ_BASE(json.size(), v.get_stringify_size());
+    EXPECT_EQ_BASE(true, (json.capacity() < 2 * json.size()));
+
+    // it writes the same text as without exact_size behind what str held, also through the links of a copied tree
+    Json tree, x;
+    EXPECT_EQ_BASE(PARSE_OK, tree.parse("{\"s\":\"tab\\t quote\\\" \\u0001 \\u00e9\",\"n\":[0,-1.5e-300,1e21,3],\"o\":{\"k\":[true,false,null]}}"));
+    Json linked(tree);
+    x.set_number(7);
+    linked.set_object_value("x", x);
+    string plain = "prefix", exact = "prefix";
+    linked.stringify(plain);
+    linked.stringify(exact, true);
+    EXPECT_EQ_BASE(plain, exact);
+    EXPECT_EQ_BASE(exact.size(), 6 + linked.get_stringify_size());
+}
+
+// counters are only there in a JSON_STATS build, otherwise every Stats comes back zeroed
+static void test_stats() {
+    const string json = "{\"a\":[1,2.5,1e300,\"x\\u0001\\n\\uD83D\\uDE00\"],\"long key beyond sso ....\":{\"c\":null,\"d\":[true,false]}} ";
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        Stats stats;
+        Json v;
+        EXPECT_EQ_BASE(PARSE_OK, v.parse(json, stats, (PARSE_ENGINE)engine));
+#if JSON_STATS
+        EXPECT_EQ_BASE(json.size(), stats.bytes);
+        EXPECT_EQ_BASE(1, stats.nodes[JSON_NULL]);
+        EXPECT_EQ_BASE(1, stats.nodes[JSON_TRUE]);
+        EXPECT_EQ_BASE(1, stats.nodes[JSON_FALSE]);
+        EXPECT_EQ_BASE(3, stats.nodes[JSON_NUMBER]);
+        EXPECT_EQ_BASE(1, stats.nodes[JSON_STRING]);
+        EXPECT_EQ_BASE(2, stats.nodes[JSON_ARRAY]);
+        EXPECT_EQ_BASE(2, stats.nodes[JSON_OBJECT]);
+        EXPECT_EQ_BASE(11, stats.total_nodes());
+        EXPECT_EQ_BASE(4, stats.keys);
+        EXPECT_EQ_BASE(3, stats.max_depth);
+        // "x", \u0001, \n and four bytes of the emoji, plus the keys
+        EXPECT_EQ_BASE(7 + 1 + 24 + 1 + 1, stats.string_bytes);
+        EXPECT_EQ_BASE(3, stats.escapes);
+        EXPECT_EQ_BASE(3, stats.numbers);
+        EXPECT_EQ_BASE(1, stats.slow_numbers);
+        // both member vectors grow 1 -> 2, the arrays 1 -> 2 -> 4 and 1 -> 2, and the long key is too long for SSO
+        EXPECT_EQ_BASE(2 + 2 + 3 + 2 + 1, stats.allocs);
+        EXPECT_EQ_BASE(true, (stats.seconds >= stats.index_seconds));
+#else
+        EXPECT_EQ_BASE(0, stats.bytes);
+        EXPECT_EQ_BASE(0, stats.total_nodes());
+#endif
+
+        // stringify sees the same tree, escapes are counted as written, i.e. the emoji is no escape any more
+        string out;
+        Stats written;
+        v.stringify(out, written);
+#if JSON_STATS
+        EXPECT_EQ_BASE(out.size(), written.bytes);
+        EXPECT_EQ_BASE(stats.total_nodes(), written.total_nodes());
+        EXPECT_EQ_BASE(stats.keys, written.keys);
+        EXPECT_EQ_BASE(stats.max_depth, written.max_depth);
+        EXPECT_EQ_BASE(stats.string_bytes, written.string_bytes);
+        EXPECT_EQ_BASE(2, written.escapes);
+        EXPECT_EQ_BASE(3, written.numbers);
+#else
+        EXPECT_EQ_BASE(0, written.bytes);
+#endif
+    }
+
+    // a failed parse counts up to the error
+    Stats stats;
+    JsonValue v;
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, v.parse("[1,2 3]", stats));
+#if JSON_STATS
+    EXPECT_EQ_BASE(5, stats.bytes);
+    EXPECT_EQ_BASE(2, stats.nodes[JSON_NUMBER]);
+#else
+    EXPECT_EQ_BASE(0, stats.bytes);
+#endif
 }
 
 static void test_stringify() {
@@ -390,9 +1191,14 @@ static void test_stringify() {
     TEST_ROUNDTRIP("true");
 
     test_stringify_number();
+    test_stringify_nonfinite();
+    test_stringify_number_roundtrip();
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_sink();
+    test_stringify_size();
+    test_stats();
 }
 
 // v1 & v2 parse their json respectively, then compare their equality by == operator
@@ -444,6 +1250,31 @@ static void test_move() {
     v3.move(v2);
     EXPECT_EQ_BASE(JSON_NULL, v2.get_type());
     EXPECT_EQ_BASE(true, (v3 == v1));
+
+    // move ctor/assignment leave the source as a usable null json
+    Json v4(std::move(v3));
+    EXPECT_EQ_BASE(JSON_NULL, v3.get_type());
+    EXPECT_EQ_BASE(true, (v4 == v1));
+    v3 = std::move(v4);
+    EXPECT_EQ_BASE(JSON_NULL, v4.get_type());
+    EXPECT_EQ_BASE(true, (v3 == v1));
+
+    // rvalue elements are moved into containers, shared ones are still copied
+    Json a, e;
+    a.set_array();
+    e.set_string("Hello");
+    a.pushback_array_element(std::move(e));
+    EXPECT_EQ_BASE(JSON_NULL, e.get_type());
+    EXPECT_EQ_BASE("Hello", a.get_array_element(0).get_string());
+    e.set_string("World!");
+    Json alias(e);
+    a.insert_array_element(0, std::move(e));
+    EXPECT_EQ_BASE("World!", alias.get_string());
+    EXPECT_EQ_BASE("World!", a.get_array_element(0).get_string());
+    Json o;
+    o.set_object();
+    o.set_object_value("a", std::move(a));
+    EXPECT_EQ_BASE(2, o.get_object_value("a").get_array_size());
 }
 
 static void test_swap() {
@@ -455,6 +1286,138 @@ static void test_swap() {
     EXPECT_EQ_BASE("Hello", v2.get_string());
 }
 
+static void test_document() {
+    const string json = "{\"n\":null,\"s\":\"a string longer than the small buffer\",\"a\":[1,[2,{\"k\":\"v\"}],3]}";
+    Json heap, arena;
+    EXPECT_EQ_BASE(PARSE_OK, heap.parse(json));
+    EXPECT_EQ_BASE(PARSE_OK, arena.parse_document(json));
+    EXPECT_EQ_BASE(true, (heap == arena));
+
+    // values copied out of the arena live on the global heap and survive the document
+    Json a = arena.get_object_value("a");
+    arena = Json();
+    EXPECT_EQ_BASE(3, a.get_array_size());
+    EXPECT_EQ_BASE("v", a.get_array_element(1).get_array_element(1).get_object_value("k").get_string());
+
+    // mutating an arena-backed json allocates from the same arena
+    EXPECT_EQ_BASE(PARSE_OK, arena.parse_document(json));
+    Json e;
+    e.set_string("another string longer than the small buffer");
+    arena.set_object_value("e", e);
+    arena.remove_object_value("s");
+    EXPECT_EQ_BASE(3, arena.get_object_size());
+    EXPECT_EQ_BASE("another string longer than the small buffer", arena.get_object_value("e").get_string());
+
+    Document doc(64);
+    EXPECT_EQ_BASE(PARSE_OK, doc.parse(json));
+    EXPECT_EQ_BASE(JSON_OBJECT, doc.get_root().get_type());
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, doc.parse("[1"));
+    EXPECT_EQ_BASE(JSON_NULL, doc.get_root().get_type());
+    EXPECT_EQ_BASE(PARSE_OK, doc.parse("[\"x\"]"));
+    EXPECT_EQ_BASE(1, doc.get_root().get_array_size());
+}
+
+static void test_lazy() {
+    string json = " { \"n\" : null , \"f\" : false, \"t\" : true , \"i\" : 123 , \"s\" : \"abc\\u20AC\", "
+                  "\"a\" : [ 1, [2, \"]\"], {\"x\" : \"}\"} ], \"o\" : { \"1\" : 1, \"2\" : 2, \"3\" : 3 }, \"k\\\"ey\" : -1.5e3 } ";
+    LazyValue root(json);
+    EXPECT_EQ_BASE(PARSE_OK, root.get_error());
+    EXPECT_EQ_BASE(JSON_OBJECT, root.get_type());
+    EXPECT_EQ_BASE(8, root.get_object_size());
+    EXPECT_EQ_BASE(JSON_NULL, root.get_object_value("n").get_type());
+    EXPECT_EQ_BASE(JSON_FALSE, root.get_object_value("f").get_type());
+    EXPECT_EQ_BASE(JSON_TRUE, root.get_object_value("t").get_type());
+
+    double d = 0.0;
+    EXPECT_EQ_BASE(PARSE_OK, root.get_object_value("i").get_number(d));
+    EXPECT_EQ_BASE(123.0, d);
+    JsonValue::String str;
+    EXPECT_EQ_BASE(PARSE_OK, root.get_object_value("s").get_string(str));
+    EXPECT_EQ_BASE("abc\xE2\x82\xAC", str);
+    EXPECT_EQ_BASE(PARSE_OK, root.get_object_value("k\"ey").get_number(d));
+    EXPECT_EQ_BASE(-1500.0, d);
+
+    // brackets inside strings must not confuse skipping
+    LazyValue arr = root.get_object_value("a");
+    EXPECT_EQ_BASE(3, arr.get_array_size());
+    EXPECT_EQ_BASE(2, arr.get_array_element(1).get_array_size());
+    EXPECT_EQ_BASE(PARSE_OK, arr.get_array_element(2).get_object_value("x").get_string(str));
+    EXPECT_EQ_BASE("}", str);
+    EXPECT_EQ_BASE(PARSE_OK, root.get_object_value("o").get_object_value("3").get_number(d));
+    EXPECT_EQ_BASE(3.0, d);
+
+    // materialized values are the same as the ones of a whole parse
+    JsonValue whole, jv;
+    EXPECT_EQ_BASE(PARSE_OK, whole.parse(json));
+    EXPECT_EQ_BASE(PARSE_OK, arr.get_value(jv));
+    EXPECT_EQ_BASE(true, (jv == whole.get_object_value("a")));
+
+    // missing keys, out of range indexes and wrong types
+    EXPECT_EQ_BASE(false, root.find_object_key("missing"));
+    EXPECT_EQ_BASE(true, root.find_object_key("o"));
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, root.get_object_value("missing").get_error());
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, arr.get_array_element(3).get_error());
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, arr.get_object_value("x").get_error());
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, root.get_object_value("s").get_number(d));
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, root.get_object_value("missing").get_object_value("x").get_error());
+
+    // errors are only found on the way to a value
+    EXPECT_EQ_BASE(PARSE_EXPECT_VALUE, LazyValue(" ").get_error());
+    EXPECT_EQ_BASE(PARSE_INVALID_VALUE, LazyValue("nul").get_error());
+    EXPECT_EQ_BASE(PARSE_MISS_COLON, LazyValue("{\"a\" 1}").get_object_value("a").get_error());
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_CURLY_BRACKET, LazyValue("{\"a\":1 \"b\":2}").get_object_value("b").get_error());
+    EXPECT_EQ_BASE(PARSE_MISS_QUOTATION_MARK, LazyValue("[1, \"abc]").get_array_element(2).get_error());
+    EXPECT_EQ_BASE(PARSE_OK, LazyValue("{\"a\":[1 2], \"b\":2}").get_object_value("b").get_error());
+    EXPECT_EQ_BASE(PARSE_NUMBER_TOO_BIG, LazyValue("[1e309]").get_array_element(0).get_number(d));
+
+    // [json, end) needs no terminator, each text sits in a heap block of exactly its size, so ASan sees any read past it
+    struct {
+        const char* text;
+        int error;
+    } truncated[] = {
+        {"nul", PARSE_INVALID_VALUE}, {"fals", PARSE_INVALID_VALUE}, {"", PARSE_EXPECT_VALUE}, {"  ", PARSE_EXPECT_VALUE},
+        {"[", PARSE_EXPECT_VALUE}, {"[1,2", PARSE_MISS_COMMA_OR_SQUARE_BRACKET}, {"[1,2,", PARSE_EXPECT_VALUE},
+        {"[1, tru", PARSE_INVALID_VALUE}, {"[\"ab", PARSE_MISS_QUOTATION_MARK}, {"[[1,2]", PARSE_MISS_COMMA_OR_SQUARE_BRACKET},
+        {"[\"a\\", PARSE_MISS_QUOTATION_MARK}, {"{", PARSE_MISS_KEY}, {"{\"a\"", PARSE_MISS_COLON},
+        {"{\"a\" ", PARSE_MISS_COLON}, {"{\"a\":", PARSE_EXPECT_VALUE}, {"{\"a\":1", PARSE_MISS_COMMA_OR_CURLY_BRACKET},
+        {"{\"a\":1,", PARSE_MISS_KEY}, {"{\"a\":{\"b\":1}", PARSE_MISS_COMMA_OR_CURLY_BRACKET}, {"{\"a", PARSE_MISS_QUOTATION_MARK}
+    };
+    for (const auto& t : truncated) {
+        size_t len = strlen(t.text);
+        unique_ptr<char[]> buf(new char[len]);
+        memcpy(buf.get(), t.text, len);
+        LazyValue v(buf.get(), buf.get() + len);
+        // walking to a value behind the last one has to run into the end of the text
+        int error = v.get_error();
+        if (error == PARSE_OK) {
+            error = v.get_type() == JSON_ARRAY ? v.get_array_element(9).get_error() : v.get_object_value("z").get_error();
+        }
+        EXPECT_EQ_BASE(t.error, error);
+        EXPECT_EQ_BASE(0, v.get_array_size());
+        EXPECT_EQ_BASE(0, v.get_object_size());
+    }
+
+    // complete texts without a terminator behind them
+    const char* complete[] = {"null", "[1,2]", "{\"a\":[true]}", "-12.5", "\"x\""};
+    for (const char* text : complete) {
+        size_t len = strlen(text);
+        unique_ptr<char[]> buf(new char[len]);
+        memcpy(buf.get(), text, len);
+        JsonValue expect;
+        EXPECT_EQ_BASE(PARSE_OK, expect.parse(text));
+        EXPECT_EQ_BASE(PARSE_OK, LazyValue(buf.get(), buf.get() + len).get_value(jv));
+        EXPECT_EQ_BASE(true, (jv == expect));
+    }
+    unique_ptr<char[]> buf(new char[8]);
+    memcpy(buf.get(), "[1,[2],3", 8);
+    LazyValue unclosed(buf.get(), buf.get() + 8);
+    EXPECT_EQ_BASE(PARSE_OK, unclosed.get_array_element(2).get_number(d));
+    EXPECT_EQ_BASE(3.0, d);
+    EXPECT_EQ_BASE(PARSE_OK, unclosed.get_array_element(1).get_array_element(0).get_number(d));
+    EXPECT_EQ_BASE(2.0, d);
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, unclosed.get_array_element(3).get_error());
+}
+
 static void test_access_null() {
     Json v;
     v.set_string("a");
@@ -485,6 +1448,21 @@ static void test_access_string() {
     EXPECT_EQ_BASE(JSON_STRING, v.get_type());
     v.set_string("Hello");
     EXPECT_EQ_BASE("Hello", v.get_string());
+    // the std::string overloads from before pmr still work
+    string s = "a string which is longer than sso";
+    v.set_string(s);
+    EXPECT_EQ_BASE(s, v.get_string());
+    v.set_string(string("moved"));
+    EXPECT_EQ_BASE("moved", v.get_string());
+    EXPECT_EQ_BASE(string("moved"), string(v.get_string()));
+    JsonValue jv;
+    jv.set_string(std::move(s));
+    EXPECT_EQ_BASE("a string which is longer than sso", jv.get_string());
+    // an owning std::string, where the former const string& was kept
+    string copy = jv.get_string_copy();
+    jv.set_string("changed");
+    EXPECT_EQ_BASE(string("a string which is longer than sso"), copy);
+    EXPECT_EQ_BASE(string("moved"), v.get_string_copy());
 }
 
 static void test_access_array() {
@@ -560,6 +1538,19 @@ static void test_access_array() {
     EXPECT_EQ_BASE(i, a.get_array_capacity());
     a.shrink_array();
     EXPECT_EQ_BASE(0, a.get_array_capacity());
+
+    // a std::vector as before pmr, its elements are copied
+    vector<JsonValue> elems(2);
+    elems[0].set_number(1);
+    elems[1].set_string("a string which is longer than sso");
+    JsonValue jv;
+    jv.set_array(elems);
+    EXPECT_EQ_BASE(2, jv.get_array_size());
+    EXPECT_EQ_BASE(1.0, jv.get_array_element(0).get_number());
+    EXPECT_EQ_BASE("a string which is longer than sso", jv.get_array_element(1).get_string());
+    elems.clear();
+    jv.set_array(elems);
+    EXPECT_EQ_BASE(0, jv.get_array_size());
 }
 
 static void test_access_object() {
@@ -611,6 +1602,48 @@ static void test_access_object() {
 
     o.clear_object();
     EXPECT_EQ_BASE(0, o.get_object_size());
+
+    // grow past the hash index threshold, then remove keys from the middle
+    for (i = 0; i < 100; ++i) {
+        v.set_number(i);
+        o.set_object_value("key" + to_string(i), v);
+    }
+    EXPECT_EQ_BASE(100, o.get_object_size());
+    for (i = 0; i < 100; i += 2) {
+        o.remove_object_value("key" + to_string(i));
+    }
+    EXPECT_EQ_BASE(50, o.get_object_size());
+    for (i = 0; i < 100; ++i) {
+        string key = "key" + to_string(i);
+        EXPECT_EQ_BASE((i % 2 == 1), o.find_object_key(key));
+        if (i % 2 == 1) {
+            EXPECT_EQ_BASE((double)i, o.get_object_value(key).get_number());
+        }
+    }
+    v.set_string("again");
+    o.set_object_value("key1", v);
+    EXPECT_EQ_BASE(50, o.get_object_size());
+    EXPECT_EQ_BASE("again", o.get_object_value("key1").get_string());
+
+    // a duplicated key keeps its first position and the last value
+    EXPECT_EQ_BASE(PARSE_OK, o.parse("{\"a\":1,\"b\":2,\"a\":3}"));
+    EXPECT_EQ_BASE(2, o.get_object_size());
+    EXPECT_EQ_BASE(3.0, o.get_object_value("a").get_number());
+    string json;
+    o.stringify(json);
+    EXPECT_EQ_BASE("{\"a\":3,\"b\":2}", json);
+
+    // a std::map as before JsonObject, members come in key order
+    map<string, JsonValue> members;
+    members["z"].set_number(1);
+    members["a"].set_string("x");
+    JsonValue jv;
+    jv.set_object(members);
+    EXPECT_EQ_BASE(2, jv.get_object_size());
+    EXPECT_EQ_BASE(1.0, jv.get_object_value("z").get_number());
+    json.clear();
+    jv.stringify(json);
+    EXPECT_EQ_BASE("{\"a\":\"x\",\"z\":1}", json);
 }
 
 static void test_access() {
@@ -622,7 +1655,527 @@ static void test_access() {
     test_access_object();
 }
 
+// counts of tracker since before, tests compare them exactly so a new allocation in a hot path fails here
+static AllocCounts allocs_since(const AllocCounts& before) {
+    return tracker.get_counts() - before;
+}
+
+static void test_ref() {
+    Json j;
+    EXPECT_EQ_BASE(PARSE_OK, j.parse("{\"items\":[{\"name\":\"pen\",\"price\":1.5,\"tags\":[]},{\"name\":\"ink\",\"price\":7,\"ok\":true}],"
+                                     "\"count\":2,\"none\":null}"));
+    AllocCounts before = tracker.get_counts();
+    JsonRef root = j.get_ref();
+    EXPECT_EQ_BASE(JSON_OBJECT, root.get_type());
+    EXPECT_EQ_BASE(3, root.get_object_size());
+    EXPECT_EQ_BASE(2, root["items"].get_array_size());
+    EXPECT_EQ_BASE(1.5, root["items"][0]["price"].get_number());
+    EXPECT_EQ_BASE("ink", root["items"][1]["name"].get_string());
+    EXPECT_EQ_BASE(true, root["items"][1]["ok"].get_bool());
+    EXPECT_EQ_BASE(true, root.find_object_key("none"));
+    EXPECT_EQ_BASE(true, root["none"].exists());
+    EXPECT_EQ_BASE(JSON_NULL, root["none"].get_type());
+
+    // a missing step stays missing, typed accessors give their default then, as they do for another type
+    EXPECT_EQ_BASE(false, root["missing"].exists());
+    EXPECT_EQ_BASE(false, root["items"][2]["price"].exists());
+    EXPECT_EQ_BASE(false, root["count"][0].exists());
+    EXPECT_EQ_BASE(false, root["items"]["name"].exists());
+    EXPECT_EQ_BASE(JSON_NULL, root["missing"]["deeper"].get_type());
+    EXPECT_EQ_BASE(-1.0, root["items"][5]["price"].get_number(-1));
+    EXPECT_EQ_BASE(-1.0, root["items"][0]["name"].get_number(-1));
+    EXPECT_EQ_BASE("none", root["count"].get_string("none"));
+    EXPECT_EQ_BASE(false, root["items"].get_bool());
+    EXPECT_EQ_BASE(0, root["missing"].get_array_size());
+    EXPECT_EQ_BASE(0, root["count"].get_object_size());
+    EXPECT_EQ_BASE(false, JsonRef().find_object_key("count"));
+
+    // members in insertion order, elements in index order
+    string keys;
+    for (auto [key, value] : root.get_object()) {
+        keys += key;
+        keys += value.exists() ? "," : "?";
+    }
+    EXPECT_EQ_BASE("items,count,none,", keys);
+    double total = 0;
+    size_t count = 0;
+    for (JsonRef item : root["items"].get_array()) {
+        total += item["price"].get_number();
+        ++count;
+    }
+    EXPECT_EQ_BASE(8.5, total);
+    EXPECT_EQ_BASE(2, count);
+    EXPECT_EQ_BASE(true, root["items"][0]["tags"].get_array().empty());
+    EXPECT_EQ_BASE(true, root["count"].get_array().empty());
+    EXPECT_EQ_BASE(true, root["missing"].get_object().empty());
+
+    // nothing above allocated
+    EXPECT_EQ_BASE(0, allocs_since(before).allocs);
+
+    // refs compare like values, into the same or another tree
+    Json other;
+    EXPECT_EQ_BASE(PARSE_OK, other.parse("{\"name\":\"ink\",\"price\":7,\"ok\":true}"));
+    EXPECT_EQ_BASE(true, (root["items"][1] == other.get_ref()));
+    EXPECT_EQ_BASE(true, (root["items"][0] != other.get_ref()));
+    EXPECT_EQ_BASE(true, (root["missing"] == root["items"][9]));
+    EXPECT_EQ_BASE(true, (root["missing"] != root["none"]));
+
+    // a JsonValue converts to a ref, and a ref leads back to the same value
+    JsonValue v;
+    EXPECT_EQ_BASE(PARSE_OK, v.parse("[1,[2,3]]"));
+    JsonRef r = v;
+    EXPECT_EQ_BASE(&v.get_array_element(1), r[1].get_value());
+    EXPECT_EQ_BASE(3.0, r[1][1].get_number());
+    EXPECT_EQ_BASE(true, (r[2].get_value() == nullptr));
+}
+
+// JSON Pointer (RFC 6901), the examples of section 5 first
+static void test_pointer() {
+    Json j;
+    EXPECT_EQ_BASE(PARSE_OK, j.parse("{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,"
+                                     "\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}"));
+    JsonRef root = j.get_ref();
+    EXPECT_EQ_BASE(true, (JsonPointer("").resolve(root) == root));
+    EXPECT_EQ_BASE(true, (JsonPointer().resolve(root) == root));
+    EXPECT_EQ_BASE(2, JsonPointer("/foo").resolve(root).get_array_size());
+    EXPECT_EQ_BASE("bar", JsonPointer("/foo/0").resolve(root).get_string());
+    EXPECT_EQ_BASE(0.0, JsonPointer("/").resolve(root).get_number(-1));
+    EXPECT_EQ_BASE(1.0, JsonPointer("/a~1b").resolve(root).get_number());
+    EXPECT_EQ_BASE(2.0, JsonPointer("/c%d").resolve(root).get_number());
+    EXPECT_EQ_BASE(3.0, JsonPointer("/e^f").resolve(root).get_number());
+    EXPECT_EQ_BASE(4.0, JsonPointer("/g|h").resolve(root).get_number());
+    EXPECT_EQ_BASE(5.0, JsonPointer("/i\\j").resolve(root).get_number());
+    EXPECT_EQ_BASE(6.0, JsonPointer("/k\"l").resolve(root).get_number());
+    EXPECT_EQ_BASE(7.0, JsonPointer("/ ").resolve(root).get_number());
+    EXPECT_EQ_BASE(8.0, JsonPointer("/m~0n").resolve(root).get_number());
+
+    // tokens are unescaped once, "~01" is "~1" and not "/"
+    JsonPointer p("/m~0n/~01/a~1b/");
+    EXPECT_EQ_BASE(true, p.is_valid());
+    EXPECT_EQ_BASE(4, p.size());
+    EXPECT_EQ_BASE("m~n", p.get_token(0));
+    EXPECT_EQ_BASE("~1", p.get_token(1));
+    EXPECT_EQ_BASE("a/b", p.get_token(2));
+    EXPECT_EQ_BASE("", p.get_token(3));
+    EXPECT_EQ_BASE(0, JsonPointer("").size());
+    EXPECT_EQ_BASE(1, JsonPointer("/").size());
+
+    // invalid pointers resolve to nothing
+    EXPECT_EQ_BASE(false, JsonPointer("foo").is_valid());
+    EXPECT_EQ_BASE(false, JsonPointer("#/foo").is_valid());
+    EXPECT_EQ_BASE(false, JsonPointer("/~").is_valid());
+    EXPECT_EQ_BASE(false, JsonPointer("/a~2").is_valid());
+    EXPECT_EQ_BASE(false, JsonPointer("foo").resolve(root).exists());
+    EXPECT_EQ_BASE(0, JsonPointer("/a~").size());
+    EXPECT_EQ_BASE(true, p.parse("/foo/1"));
+    EXPECT_EQ_BASE("baz", p.resolve(root).get_string());
+
+    // array indexes are digits without a leading zero, "-" is behind the last element, so it never exists
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/2").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/01").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/-").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/+1").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/99999999999999999999").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/foo/0/0").resolve(root).exists());
+    EXPECT_EQ_BASE(false, JsonPointer("/missing/0").resolve(root).exists());
+
+    // digits are keys in an object, and objects big enough for the hash index use the hash of the token
+    Json big;
+    string text = "{";
+    for (int i = 0; i < 40; ++i) text += (i ? ",\"" : "\"") + to_string(i) + "\":{\"v\":" + to_string(i) + "}";
+    text += ",\"01\":[10,11]}";
+    EXPECT_EQ_BASE(PARSE_OK, big.parse(text));
+    JsonRef broot = big.get_ref();
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_EQ_BASE((double)i, JsonPointer("/" + to_string(i) + "/v").resolve(broot).get_number(-1));
+    }
+    EXPECT_EQ_BASE(11.0, JsonPointer("/01/1").resolve(broot).get_number());
+    EXPECT_EQ_BASE(false, JsonPointer("/40/v").resolve(broot).exists());
+
+    // a set resolves shared prefixes once, each pointer keeps its slot
+    JsonPointerSet set;
+    EXPECT_EQ_BASE(0, set.add("/foo/1"));
+    EXPECT_EQ_BASE(1, set.add("/foo/0"));
+    EXPECT_EQ_BASE(2, set.add("bad"));
+    EXPECT_EQ_BASE(3, set.add(""));
+    EXPECT_EQ_BASE(4, set.add("/foo/7"));
+    EXPECT_EQ_BASE(5, set.add("/missing/x"));
+    EXPECT_EQ_BASE(6, set.add(JsonPointer("/a~1b")));
+    EXPECT_EQ_BASE(7, set.add("/foo/1"));
+    EXPECT_EQ_BASE(8, set.size());
+    vector<JsonRef> out;
+    set.resolve(root, out);
+    EXPECT_EQ_BASE(8, out.size());
+    EXPECT_EQ_BASE("baz", out[0].get_string());
+    EXPECT_EQ_BASE("bar", out[1].get_string());
+    EXPECT_EQ_BASE(false, out[2].exists());
+    EXPECT_EQ_BASE(true, (out[3] == root));
+    EXPECT_EQ_BASE(false, out[4].exists());
+    EXPECT_EQ_BASE(false, out[5].exists());
+    EXPECT_EQ_BASE(1.0, out[6].get_number());
+    EXPECT_EQ_BASE(out[0].get_value(), out[7].get_value());
+
+    // a set can be reused for another document, slots of the last one are cleared
+    Json other;
+    EXPECT_EQ_BASE(PARSE_OK, other.parse("{\"foo\":[true],\"a/b\":\"x\"}"));
+    set.resolve(other.get_ref(), out);
+    EXPECT_EQ_BASE(false, out[0].exists());
+    EXPECT_EQ_BASE(true, out[1].get_bool());
+    EXPECT_EQ_BASE("x", out[6].get_string());
+
+    // resolving allocates nothing, neither one pointer nor a set into a sized buffer
+    JsonPointer deep("/foo/1");
+    AllocCounts before = tracker.get_counts();
+    EXPECT_EQ_BASE("baz", deep.resolve(root).get_string());
+    set.resolve(root, out);
+    EXPECT_EQ_BASE(0, allocs_since(before).allocs);
+}
+
+// select path from json, the matches are checked against expect, a json array of them
+static void check_path(const char* json, const char* path, const char* expect) {
+    JsonPath jp(path);
+    EXPECT_EQ_BASE(true, jp.is_valid());
+    JsonValue all;
+    EXPECT_EQ_BASE(PARSE_OK, all.parse(expect));
+    for (int engine = ENGINE_RECURSIVE; engine <= ENGINE_STAGED; ++engine) {
+        vector<JsonValue> out;
+        EXPECT_EQ_BASE(PARSE_OK, jp.select(json, out, (PARSE_ENGINE)engine));
+        EXPECT_EQ_BASE(all.get_array_size(), out.size());
+        for (size_t i = 0; i < out.size() && i < all.get_array_size(); ++i) {
+            EXPECT_EQ_BASE(true, (out[i] == all.get_array_element(i)));
+        }
+    }
+}
+
+static void test_path() {
+    const char* store = "{\"store\":{\"book\":["
+                        "{\"category\":\"ref\",\"author\":\"A\",\"price\":8.95},"
+                        "{\"category\":\"fic\",\"author\":\"B\",\"price\":12.99,\"isbn\":\"x\"},"
+                        "{\"category\":\"fic\",\"author\":\"C\",\"price\":8.99},"
+                        "{\"category\":\"fic\",\"author\":\"D\",\"price\":22.99}],"
+                        "\"bicycle\":{\"color\":\"red\",\"price\":19.95}}}";
+    check_path(store, "$.store.book[*].author", "[\"A\",\"B\",\"C\",\"D\"]");
+    check_path(store, "$..author", "[\"A\",\"B\",\"C\",\"D\"]");
+    check_path(store, "$.store..price", "[8.95,12.99,8.99,22.99,19.95]");
+    check_path(store, "$..book[2].author", "[\"C\"]");
+    check_path(store, "$..book[4]", "[]");
+    check_path(store, "$..book[0:2].price", "[8.95,12.99]");
+    check_path(store, "$..book[1:].author", "[\"B\",\"C\",\"D\"]");
+    check_path(store, "$..book[::2].author", "[\"A\",\"C\"]");
+    check_path(store, "$..book[:].isbn", "[\"x\"]");
+    check_path(store, "$[\"store\"]['bicycle'].color", "[\"red\"]");
+    check_path(store, "$.store.bicycle", "[{\"color\":\"red\",\"price\":19.95}]");
+    check_path(store, "$.store.*.color", "[\"red\"]");
+    check_path(store, "$.store.book.author", "[]");
+    check_path(store, "$.store[0]", "[]");
+    check_path(store, "$..[0].author", "[\"A\"]");
+    check_path(store, "$", (string("[") + store + "]").c_str());
+    // every value but the root, in document order
+    JsonPath all("$..*");
+    vector<JsonValue> out;
+    EXPECT_EQ_BASE(PARSE_OK, all.select(store, out));
+    EXPECT_EQ_BASE(22, out.size());
+    EXPECT_EQ_BASE(JSON_OBJECT, out[0].get_type());
+    EXPECT_EQ_BASE(JSON_ARRAY, out[1].get_type());
+    EXPECT_EQ_BASE("red", out[20].get_string());
+
+    // an outer match comes before the matches inside it, each of them is a whole value
+    check_path("{\"a\":{\"a\":{\"a\":1}},\"b\":[{\"a\":[2]}]}", "$..a", "[{\"a\":{\"a\":1}},{\"a\":1},1,[2]]");
+    check_path("[[0,1],[2,[3,4]]]", "$..[1]", "[1,[2,[3,4]],[3,4],4]");
+    check_path("[10,11,12,13,14,15,16]", "$[2:6:3]", "[12,15]");
+    check_path("{\"a b\":{\"it's\":1},\"\\u0041\":2}", "$['a b']['it\\'s']", "[1]");
+    check_path("{\"a b\":1,\"\\u0041\":2}", "$.A", "[2]");
+    check_path("\"scalar\"", "$", "[\"scalar\"]");
+    check_path("\"scalar\"", "$.a", "[]");
+
+    // paths outside the subset, negative indexes need the length of an array
+    const char* invalid[] = {"", "store", "$.", "$..", "$[", "$[1", "$[a]", "$[-1]", "$[0:-1]", "$.a[::0]", "$.a b",
+                             "$['a]", "$.[0]", "$*", "$.a[1,2]", "$[?(@.a)]"};
+    for (const char* path : invalid) {
+        JsonPath jp(path);
+        EXPECT_EQ_BASE(false, jp.is_valid());
+        EXPECT_EQ_BASE(0, jp.size());
+        EXPECT_EQ_BASE(PARSE_OK, jp.select(store, out));
+        EXPECT_EQ_BASE(0, out.size());
+    }
+    string deep = "$";
+    for (size_t i = 0; i < JsonPath::MAX_STEPS; ++i) deep += ".a";
+    EXPECT_EQ_BASE(true, JsonPath(deep).is_valid());
+    EXPECT_EQ_BASE(false, JsonPath(deep + ".a").is_valid());
+
+    // the whole text is still checked, an error drops all matches
+    JsonPath price("$..price");
+    EXPECT_EQ_BASE(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, price.select("{\"price\":1,\"x\":[1,2}", out));
+    EXPECT_EQ_BASE(0, out.size());
+    EXPECT_EQ_BASE(PARSE_ROOT_NOT_SINGULAR, price.select("{\"price\":1} x", out));
+    EXPECT_EQ_BASE(0, out.size());
+
+    // subtrees without a match build nothing, only the match allocates
+    string big = "{\"skip\":[";
+    for (int i = 0; i < 100; ++i) big += "{\"name\":\"a string which is longer than sso\",\"v\":[1,2,3]},";
+    big += "0],\"keep\":{\"v\":[1,2,3]}}";
+    JsonPath keep("$.keep.v");
+    AllocCounts before = tracker.get_counts();
+    EXPECT_EQ_BASE(PARSE_OK, keep.select(big, out));
+    EXPECT_EQ_BASE(1, out.size());
+    EXPECT_EQ_BASE(3, out[0].get_array_size());
+    // the array growing 1 -> 2 -> 4
+    EXPECT_EQ_BASE(3, allocs_since(before).allocs);
+
+    // PathMatcher is a handler like any other, so it runs over a text arriving in chunks too
+    PathMatcher matcher(price, out);
+    GenericStreamParser<PathMatcher> stream(matcher);
+    string text = store;
+    out.clear();
+    for (size_t i = 0; i < text.size(); i += 7) {
+        EXPECT_EQ_BASE(PARSE_OK, stream.feed(text.data() + i, min<size_t>(7, text.size() - i)));
+    }
+    EXPECT_EQ_BASE(PARSE_OK, stream.finish());
+    EXPECT_EQ_BASE(5, out.size());
+    EXPECT_EQ_BASE(19.95, out[4].get_number());
+}
+
+// copies and children are snapshots, a change through one handle is never seen through another
+static void test_cow() {
+    Json j;
+    EXPECT_EQ_BASE(PARSE_OK, j.parse("{\"a\":[1,2,3],\"b\":{\"c\":\"x\"}}"));
+    Json copy(j), a = j.get_object_value("a"), b = j.get_object_value("b");
+
+    a.pushback_array_element(a.get_array_element(0));
+    EXPECT_EQ_BASE(4, a.get_array_size());
+    EXPECT_EQ_BASE(3, j.get_object_value("a").get_array_size());
+    b.set_object_value("c", a);
+    EXPECT_EQ_BASE(JSON_STRING, j.get_object_value("b").get_object_value("c").get_type());
+
+    j.remove_object_value("a");
+    EXPECT_EQ_BASE(1, j.get_object_size());
+    EXPECT_EQ_BASE(2, copy.get_object_size());
+    EXPECT_EQ_BASE(3, copy.get_object_value("a").get_array_size());
+    j.set_number(1.5);
+    EXPECT_EQ_BASE(JSON_OBJECT, copy.get_type());
+
+    // a child outlives its parent handle, after that it is the only owner and changes in place
+    Json c;
+    {
+        Json parent;
+        EXPECT_EQ_BASE(PARSE_OK, parent.parse("[[1,2],[3]]"));
+        c = parent.get_array_element(0);
+        JsonRef before = c.get_ref();
+        parent.set_array();
+        c.popback_array_element();
+        EXPECT_EQ_BASE(true, (before.get_value() == c.get_ref().get_value()));
+    }
+    EXPECT_EQ_BASE(1, c.get_array_size());
+
+    // but not while a copy of the parent links to it
+    Json kept;
+    {
+        Json parent;
+        EXPECT_EQ_BASE(PARSE_OK, parent.parse("[[1,2],[3]]"));
+        kept = parent;
+        kept.popback_array_element();
+        c = parent.get_array_element(0);
+    }
+    c.popback_array_element();
+    EXPECT_EQ_BASE(1, c.get_array_size());
+    EXPECT_EQ_BASE(2, kept.get_array_element(0).get_array_size());
+
+    // the same when the default resource changed in between, links are told by their flag, not by a resource
+    {
+        TrackingResource inner(&tracker);
+        Json p, q, z;
+        EXPECT_EQ_BASE(PARSE_OK, p.parse("{\"a\":1,\"b\":[1,2]}"));
+        q = p;
+        z.set_number(9);
+        q.set_object_value("z", z);
+        pmr::set_default_resource(&inner);
+        c = p.get_object_value("b");
+        p = Json();
+        c.pushback_array_element(z);
+        pmr::set_default_resource(&tracker);
+        EXPECT_EQ_BASE(3, c.get_array_size());
+        string out;
+        q.stringify(out);
+        EXPECT_EQ_BASE("{\"a\":1,\"b\":[1,2],\"z\":9}", out);
+        c = Json();
+    }
+
+    // a child reached through a link is shared with the tree the link points into
+    Json base, next;
+    EXPECT_EQ_BASE(PARSE_OK, base.parse("{\"a\":[1]}"));
+    next = base;
+    next.set_object_value("b", base);
+    c = next.get_object_value("a");
+    c.set_array();
+    EXPECT_EQ_BASE(1, base.get_object_value("a").get_array_size());
+    EXPECT_EQ_BASE(1, next.get_object_value("a").get_array_size());
+    EXPECT_EQ_BASE(1, next.get_object_value("b").get_object_value("a").get_array_size());
+    EXPECT_EQ_BASE(true, (next.get_object_value("b") == base));
+
+    // a Document is changed in place, a shared value is copied into its arena instead of linked
+    Json doc, elem;
+    EXPECT_EQ_BASE(PARSE_OK, doc.parse_document("[[1],2]"));
+    EXPECT_EQ_BASE(PARSE_OK, elem.parse("[3,4]"));
+    JsonRef root_before = doc.get_ref();
+    doc.pushback_array_element(elem);
+    EXPECT_EQ_BASE(true, (root_before.get_value() == doc.get_ref().get_value()));
+    EXPECT_EQ_BASE(false, (doc.get_ref()[2].get_value() == elem.get_ref().get_value()));
+    EXPECT_EQ_BASE(true, (doc.get_array_element(2) == elem));
+    doc = Json();
+
+    // readers always see a root which some writer published, never one in the middle of a change
+    JsonPublisher publisher;
+    Json root;
+    root.set_object();
+    Json zero;
+    zero.set_number(0);
+    root.set_object_value("x", zero);
+    root.set_object_value("y", zero);
+    publisher.store(root);
+    const int updates = 200;
+    vector<thread> threads;
+    bool consistent = true;
+    atomic<bool> done(false);
+    threads.emplace_back([&] {
+        while (!done.load()) {
+            Json snap = publisher.load();
+            if (snap.get_object_value("x").get_number() != snap.get_object_value("y").get_number()) consistent = false;
+        }
+    });
+    for (int w = 0; w < 2; ++w) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < updates; ++i) {
+                publisher.update([](Json& next) {
+                    Json n;
+                    n.set_number(next.get_object_value("x").get_number() + 1);
+                    next.set_object_value("x", n);
+                    next.set_object_value("y", n);
+                });
+            }
+        });
+    }
+    threads[1].join();
+    threads[2].join();
+    done.store(true);
+    threads[0].join();
+    EXPECT_EQ_BASE(true, consistent);
+    EXPECT_EQ_BASE(2.0 * updates, publisher.load().get_object_value("y").get_number());
+    // the first root was never changed
+    EXPECT_EQ_BASE(0.0, root.get_object_value("x").get_number());
+
+    // an update copies only the root, the members it leaves alone are the same values in both snapshots
+    JsonPublisher config;
+    Json settings;
+    EXPECT_EQ_BASE(PARSE_OK, settings.parse("{\"port\":80,\"hosts\":[\"a\",\"b\"],\"tls\":{\"on\":true}}"));
+    config.store(settings);
+    config.update([](Json& next) {
+        Json port;
+        port.set_number(8080);
+        next.set_object_value("port", port);
+    });
+    JsonRef old = settings.get_ref(), now = config.load().get_ref();
+    EXPECT_EQ_BASE(false, (old.get_value() == now.get_value()));
+    EXPECT_EQ_BASE(80.0, old["port"].get_number());
+    EXPECT_EQ_BASE(8080.0, now["port"].get_number());
+    EXPECT_EQ_BASE(true, (old["hosts"].get_value() == now["hosts"].get_value()));
+    EXPECT_EQ_BASE(true, (old["tls"].get_value() == now["tls"].get_value()));
+
+    // a change further down copies the path to it, here the root and "hosts", and nothing beside it
+    Json snap = config.load();
+    config.update([](Json& next) {
+        Json hosts = next.get_object_value("hosts"), host;
+        host.set_string("c");
+        hosts.pushback_array_element(host);
+        next.set_object_value("hosts", std::move(hosts));
+    });
+    JsonRef later = config.load().get_ref();
+    now = snap.get_ref();
+    EXPECT_EQ_BASE(2, now["hosts"].get_array_size());
+    EXPECT_EQ_BASE(3, later["hosts"].get_array_size());
+    EXPECT_EQ_BASE(false, (now["hosts"].get_value() == later["hosts"].get_value()));
+    EXPECT_EQ_BASE(true, (now["hosts"][0].get_value() == later["hosts"][0].get_value()));
+    EXPECT_EQ_BASE(true, (now["port"].get_value() == later["port"].get_value()));
+    EXPECT_EQ_BASE(true, (old["tls"].get_value() == later["tls"].get_value()));
+    string text;
+    config.load().stringify(text);
+    EXPECT_EQ_BASE("{\"port\":8080,\"hosts\":[\"a\",\"b\",\"c\"],\"tls\":{\"on\":true}}", text);
+
+    Json stale = publisher.load(), other;
+    publisher.store(other);
+    EXPECT_EQ_BASE(false, publisher.compare_exchange(stale, root));
+    EXPECT_EQ_BASE(true, publisher.compare_exchange(other, root));
+    EXPECT_EQ_BASE(true, (publisher.load() == root));
+}
+
+static void test_alloc() {
+    AllocCounts before = tracker.get_counts();
+    {
+        // node and counter of a Json are one block
+        Json j;
+        EXPECT_EQ_BASE(1, allocs_since(before).allocs);
+
+        // the member vector, and the array growing 1 -> 2 -> 4, the key fits into SSO
+        before = tracker.get_counts();
+        Stats stats;
+        EXPECT_EQ_BASE(PARSE_OK, j.parse("{\"a\":[1,2,3]}", stats));
+        EXPECT_EQ_BASE(4, allocs_since(before).allocs);
+#if JSON_STATS
+        EXPECT_EQ_BASE(4, stats.allocs);
+#endif
+
+        // children share the tree, only changing one pays a node and a copy of that child (plus the growth here)
+        before = tracker.get_counts();
+        Json a = j.get_object_value("a");
+        Json e = a.get_array_element(1);
+        EXPECT_EQ_BASE(0, allocs_since(before).allocs);
+        a.pushback_array_element(e);
+        EXPECT_EQ_BASE(3, allocs_since(before).allocs);
+
+        // copies of a Json share the node
+        before = tracker.get_counts();
+        Json shared(j);
+        EXPECT_EQ_BASE(0, allocs_since(before).allocs);
+    }
+    AllocCounts all = allocs_since(before);
+    EXPECT_EQ_BASE(0, all.allocs);
+    EXPECT_EQ_BASE(true, (all.deallocs > 0));
+
+    // a document is its own block and counter plus arena blocks, the arena gives nothing back before the document goes
+    before = tracker.get_counts();
+    {
+        Json doc;
+        AllocCounts node = allocs_since(before);
+        EXPECT_EQ_BASE(PARSE_OK, doc.parse_document("[\"a string which is longer than sso\",{\"k\":[1,2,3]}]"));
+        AllocCounts parsed = allocs_since(before);
+        EXPECT_EQ_BASE(true, (parsed.allocs >= node.allocs + 2));
+        // only the node of the Json, which now points into the document
+        EXPECT_EQ_BASE(1, parsed.deallocs);
+    }
+    all = allocs_since(before);
+    EXPECT_EQ_BASE(all.allocs, all.deallocs);
+    EXPECT_EQ_BASE(all.bytes, all.freed_bytes);
+    EXPECT_EQ_BASE(0, all.live_bytes());
+
+    // a tracker can be given to one value only, its upstream sees the same blocks
+    before = tracker.get_counts();
+    {
+        TrackingResource inner(&tracker);
+        JsonValue v{JsonValue::allocator_type(&inner)};
+        v.set_string(string(1000, 'x'));
+        EXPECT_EQ_BASE(1, inner.get_counts().allocs);
+        EXPECT_EQ_BASE(true, (inner.get_counts().bytes > 1000));
+        EXPECT_EQ_BASE(inner.get_counts().bytes, allocs_since(before).bytes);
+        EXPECT_EQ_BASE(inner.get_counts().bytes, inner.get_peak_bytes());
+        v.set_type(JSON_NULL);
+        EXPECT_EQ_BASE(0, inner.get_counts().live_bytes());
+        inner.reset_peak();
+        EXPECT_EQ_BASE(0, inner.get_peak_bytes());
+    }
+    EXPECT_EQ_BASE(0, allocs_since(before).live_bytes());
+}
+
 int main(int argc, char* argv[]) {
+    pmr::set_default_resource(&tracker);
 
     test_parse();
     test_stringify();
@@ -630,7 +2183,14 @@ int main(int argc, char* argv[]) {
     test_copy();
     test_move();
     test_swap();
+    test_document();
+    test_lazy();
     test_access();
+    test_alloc();
+    test_ref();
+    test_cow();
+    test_pointer();
+    test_path();
 
     cout << test_pass << "/" << test_count << " passed, i.e. success rate is " << test_pass * 100.0 / test_count << " %." << endl;
     return main_ret;
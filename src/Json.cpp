@@ -1,10 +1,21 @@
 #include "Json.h"
+#include "JsonDocument.h"
+#include <atomic>   // atomic_thread_fence
 
 namespace myJson {
 
+// frees a Document made by parse_document(), get_deleter() finds it through any handle into the document
+struct DocumentDeleter {
+    pmr::memory_resource* res;
+    void operator()(Document* doc) const noexcept {
+        doc->~Document();
+        res->deallocate(doc, sizeof(Document), alignof(Document));
+    }
+};
+
 // define all functions declared in Json.h
 // ctor dtor cctor rvalue etc
-Json::Json() noexcept : m_jv(new JsonValue()) {}
+Json::Json() noexcept : m_jv(make_value()) {}
 
 Json::Json(const Json& rhs) noexcept {
     m_jv = rhs.m_jv;
@@ -15,23 +26,90 @@ Json& Json::operator=(const Json& rhs) noexcept {
     return *this;
 }
 
-// Json::Json(Json&& rhs) noexcept {
-//     m_jv.reset(rhs.m_jv.release());
-// }
+Json::Json(Json&& rhs) noexcept {
+    move(rhs);
+}
 
-// Json& Json::operator=(Json&& rhs) noexcept {
-//     m_jv.reset(rhs.m_jv.release());
-//     return *this;
-// }
+Json& Json::operator=(Json&& rhs) noexcept {
+    if (this != &rhs) move(rhs);
+    return *this;
+}
 
 // parse/stringify function
-int Json::parse(const string& json) noexcept {
-    int res = m_jv->parse(json);
+int Json::parse(string_view json, PARSE_ENGINE engine) noexcept {
+    int res = fresh().parse(json, engine);
+    return res;
+}
+
+int Json::parse(const char* json, size_t len, PARSE_ENGINE engine) noexcept {
+    return fresh().parse(json, len, engine);
+}
+
+int Json::parse(const char* json, PARSE_ENGINE engine) noexcept {
+    return fresh().parse(json, engine);
+}
+
+int Json::parse(string_view json, Stats& stats, PARSE_ENGINE engine) noexcept {
+    return fresh().parse(json, stats, engine);
+}
+
+int Json::parse_insitu(char* json, size_t len) noexcept {
+    return fresh().parse_insitu(json, len);
+}
+
+int Json::parse_file(const string& path, PARSE_ENGINE engine) noexcept {
+    return fresh().parse_file(path, engine);
+}
+
+int Json::parse_document(string_view json, PARSE_ENGINE engine) noexcept {
+    // reserve about one input size as first arena block, the tree is usually a few times larger than its text
+    pmr::polymorphic_allocator<Document> alloc;
+    Document* p = new(alloc.allocate(1)) Document(json.size());
+    shared_ptr<Document> doc(p, DocumentDeleter{alloc.resource()}, alloc);
+    int res = doc->parse(json, engine);
+    // aliasing ctor, m_jv points to the root but owns the whole document
+    m_jv = shared_ptr<JsonValue>(doc, &doc->get_root());
     return res;
 }
 
-void Json::stringify(string& str) const noexcept {
-    m_jv->stringify(str);
+void Json::stringify(string& str, bool exact_size) const noexcept {
+    m_jv->stringify(str, exact_size);
+}
+
+bool Json::stringify(Sink& sink) const noexcept {
+    return m_jv->stringify(sink);
+}
+
+bool Json::stringify(int fd) const noexcept {
+    FdSink sink(fd);
+    return m_jv->stringify(sink);
+}
+
+bool Json::stringify(FILE* file) const noexcept {
+    FileSink sink(file);
+    return m_jv->stringify(sink);
+}
+
+bool Json::stringify(ostream& os) const noexcept {
+    OstreamSink sink(os);
+    return m_jv->stringify(sink);
+}
+
+bool Json::stringify(const CallbackSink::Callback& callback) const noexcept {
+    CallbackSink sink(callback);
+    return m_jv->stringify(sink);
+}
+
+void Json::stringify(string& str, Stats& stats, bool exact_size) const noexcept {
+    m_jv->stringify(str, stats, exact_size);
+}
+
+bool Json::stringify(Sink& sink, Stats& stats) const noexcept {
+    return m_jv->stringify(sink, stats);
+}
+
+size_t Json::get_stringify_size() const noexcept {
+    return m_jv->get_stringify_size();
 }
 
 // copy move swap function
@@ -40,10 +118,63 @@ void Json::copy(const Json& rhs) noexcept {
 }
 
 void Json::move(Json& rhs) noexcept {
-    m_jv = rhs.m_jv;
-    rhs.m_jv->~JsonValue();
-    // after moving action was finished, call JsonValue dtor in rhs.m_jv to assure JsonValue was moved successfully
-    // but not unique_ptr release function, coz it will destory rhs object, causing v2(in JsonTest.cpp) not available
+    // take over the whole node instead of destroying it in place, other Json objects may still share it
+    // rhs gets a fresh JSON_NULL node so that it stays usable after moving (v2 in JsonTest.cpp)
+    m_jv = std::move(rhs.m_jv);
+    rhs.m_jv = make_value();
+}
+
+JsonValue Json::take_value(Json& rhs) const noexcept {
+    if (rhs.unique()) {
+        return JsonValue(std::move(*rhs.m_jv));
+    }
+    return share_value(rhs);
+}
+
+JsonValue Json::share_value(const Json& rhs) const noexcept {
+    // with the resource of this tree, so the value moves into it without another copy
+    JsonValue jv(m_jv->get_allocator());
+    if (in_document()) {
+        jv = *rhs.m_jv;
+    } else {
+        jv.link(*rhs.m_jv, rhs.m_jv);
+    }
+    return jv;
+}
+
+bool Json::unique() const noexcept {
+    if (m_jv.use_count() != 1) return false;
+    // the last other owner may have just let go on another thread, see its reads of the tree before changing it
+    atomic_thread_fence(memory_order_acquire);
+    return true;
+}
+
+bool Json::in_document() const noexcept {
+    return get_deleter<DocumentDeleter>(m_jv) != nullptr;
+}
+
+JsonValue& Json::mut() noexcept {
+    if (!unique()) {
+        shared_ptr<JsonValue> jv = make_value();
+        jv->share(*m_jv, m_jv);
+        m_jv = std::move(jv);
+    }
+    return *m_jv;
+}
+
+JsonValue& Json::fresh() noexcept {
+    if (!unique()) m_jv = make_value();
+    return *m_jv;
+}
+
+const Json Json::child(const JsonValue& slot) const noexcept {
+    // use const Json as return value to avoid local variable problem
+    if (slot.m_link) {
+        // the link owns the tree of its target, so the child is not changed in place while that tree or this one is alive
+        return Json(slot.m_node);
+    }
+    // aliasing ctor, the child shares ownership of the whole tree, so it is never changed in place while the tree is shared
+    return Json(shared_ptr<JsonValue>(m_jv, const_cast<JsonValue*>(&slot)));
 }
 
 void Json::swap(Json& rhs) noexcept {
@@ -57,7 +188,7 @@ JSON_TYPE Json::get_type() const noexcept {
 }
 
 void Json::set_type(JSON_TYPE type) noexcept {
-    m_jv->set_type(type);
+    fresh().set_type(type);
 }
 
 double Json::get_number() const noexcept {
@@ -65,24 +196,37 @@ double Json::get_number() const noexcept {
 }
 
 void Json::set_number(double d) noexcept {
-    m_jv->set_number(d);
+    fresh().set_number(d);
 }
 
-const string& Json::get_string() const noexcept {
+string_view Json::get_string() const noexcept {
     return m_jv->get_string();
 }   
 
+string Json::get_string_copy() const noexcept {
+    return m_jv->get_string_copy();
+}
+
 size_t Json::get_string_length() const noexcept {
     return m_jv->get_string_length();
 }
 
-void Json::set_string(const string& str) noexcept {
-    m_jv->set_string(str);
+// bytes are always copied into the memory resource of m_jv, a std::string buffer can not be adopted by pmr::string
+void Json::set_string(string_view str) noexcept {
+    fresh().set_string(str);
+}
+
+void Json::set_string(const char* str) noexcept {
+    fresh().set_string(str);
+}
+
+void Json::set_string(string&& str) noexcept {
+    fresh().set_string(std::move(str));
 }
 
 void Json::set_array() noexcept {
     // use tmp object as actual parameter to construct array
-    m_jv->set_array(vector<JsonValue>());
+    fresh().set_array(JsonValue::Array());
 }
 
 size_t Json::get_array_size() const noexcept {
@@ -94,38 +238,47 @@ size_t Json::get_array_capacity() const noexcept {
 }
 
 void Json::reserve_array(size_t capacity) noexcept {
-    m_jv->reserve_array(capacity);
+    mut().reserve_array(capacity);
 }
 
 void Json::shrink_array() noexcept {
-    m_jv->shrink_array();
+    mut().shrink_array();
 }
 
 void Json::clear_array() noexcept {
-    m_jv->clear_array();
+    mut().clear_array();
 }
 
 const Json Json::get_array_element(size_t index) const noexcept {
-    // create new Json object ptr to return JsonValue object, use const Json as return value to avoid local variable problem 
-    Json res;
-    res.m_jv.reset(new JsonValue(m_jv->get_array_element(index)));
-    return res;
+    return child(m_jv->slot(index));
+}
+
+void Json::pushback_array_element(const Json& j) noexcept {
+    JsonValue jv = share_value(j);
+    mut().pushback_array_element(std::move(jv));
 }
 
-void Json::pushback_array_element(const Json& jv) noexcept {
-    m_jv->pushback_array_element(*jv.m_jv);
+void Json::pushback_array_element(Json&& j) noexcept {
+    JsonValue jv = take_value(j);
+    mut().pushback_array_element(std::move(jv));
 }
 
 void Json::popback_array_element() noexcept {
-    m_jv->popback_array_element();
+    mut().popback_array_element();
 }
 
 void Json::insert_array_element(size_t index, const Json& j) noexcept{
-    m_jv->insert_array_element(index, *j.m_jv);
+    JsonValue jv = share_value(j);
+    mut().insert_array_element(index, std::move(jv));
+}
+
+void Json::insert_array_element(size_t index, Json&& j) noexcept{
+    JsonValue jv = take_value(j);
+    mut().insert_array_element(index, std::move(jv));
 }
 
 void Json::erase_array_element(size_t index, size_t count) noexcept {
-    m_jv->erase_array_element(index, count);
+    mut().erase_array_element(index, count);
 }
 
 size_t Json::get_object_size() const noexcept {
@@ -134,11 +287,11 @@ size_t Json::get_object_size() const noexcept {
 
 // using existed fuction in std::map
 void Json::set_object() noexcept {
-    m_jv->set_object(map<string, JsonValue>());
+    fresh().set_object(JsonValue::Object());
 }
 
 void Json::clear_object() noexcept {
-    m_jv->clear_object();
+    mut().clear_object();
 }
 
 bool Json::find_object_key(const string& key) const noexcept {
@@ -146,17 +299,25 @@ bool Json::find_object_key(const string& key) const noexcept {
 }
 
 const Json Json::get_object_value(const string& key) const noexcept {
-    Json res;
-    res.m_jv.reset(new JsonValue(m_jv->get_object_value(key)));
-    return res;
+    return child(m_jv->slot(key));
 }
 
 void Json::set_object_value(const string& key, const Json& val) noexcept {
-    m_jv->set_object_value(key, *val.m_jv);
+    JsonValue jv = share_value(val);
+    mut().set_object_value(key, std::move(jv));
+}
+
+void Json::set_object_value(const string& key, Json&& val) noexcept {
+    JsonValue jv = take_value(val);
+    mut().set_object_value(key, std::move(jv));
 }
 
 void Json::remove_object_value(const string& key) noexcept {
-    m_jv->remove_object_value(key);
+    mut().remove_object_value(key);
+}
+
+JsonRef Json::get_ref() const noexcept {
+    return JsonRef(*m_jv);
 }
 
 bool operator==(const Json& lhs, const Json& rhs) noexcept {
@@ -167,4 +328,21 @@ bool operator!=(const Json& lhs, const Json& rhs) noexcept {
     return !(lhs == rhs);
 }
 
-};
\ No newline at end of file
+JsonPublisher::JsonPublisher() noexcept : m_root(Json::make_value()) {}
+
+JsonPublisher::JsonPublisher(const Json& root) noexcept : m_root(root.m_jv) {}
+
+Json JsonPublisher::load() const noexcept {
+    return Json(atomic_load(&m_root));
+}
+
+void JsonPublisher::store(const Json& root) noexcept {
+    atomic_store(&m_root, root.m_jv);
+}
+
+bool JsonPublisher::compare_exchange(const Json& expected, const Json& desired) noexcept {
+    shared_ptr<JsonValue> current = expected.m_jv;
+    return atomic_compare_exchange_strong(&m_root, &current, desired.m_jv);
+}
+
+};
@@ -1,10 +1,15 @@
 #ifndef JSON_H
 #define JSON_H
 #include <string>
-#include <memory>   // unique_ptr
+#include <string_view>
+#include <memory>   // shared_ptr, allocate_shared
+#include <memory_resource>  // polymorphic_allocator
 #include <cstddef>  // size_t
 #include "JsonEnum.h"
 #include "JsonValue.h"
+#include "JsonSink.h"
+#include "JsonAlloc.h"
+#include "JsonRef.h"
 using namespace std;
 
 namespace myJson {
@@ -12,6 +17,10 @@ namespace myJson {
 // forward delclaration
 class JsonValue;
 
+// a Json is a handle to a value, copies and the children returned by get_array_element()/get_object_value() share it
+// nothing shared is ever changed: a handle which is not the only owner copies its value first (copy on write)
+// so every copy is a snapshot, and handles of one tree can be read on several threads while others are changed
+// the copy is one level deep, its elements are links to the old ones (see JsonValue::link()), so the trees share what did not change
 class Json {
 public:
     // ctor dtor cctor rvalue etc
@@ -19,12 +28,36 @@ public:
     ~Json() noexcept {}
     Json(const Json& rhs) noexcept;
     Json& operator=(const Json& rhs) noexcept;
-    // Json(Json&& rhs) noexcept;
-    // Json& operator=(Json&& rhs) noexcept;
+    Json(Json&& rhs) noexcept;
+    Json& operator=(Json&& rhs) noexcept;
 
     // parse/stringify function
-    int parse(const string& json) noexcept;
-    void stringify(string& str) const noexcept;
+    // engine only changes the speed, see PARSE_ENGINE in JsonEnum.h
+    // the text is exactly json, nothing behind it is read, see JsonValue::parse()
+    int parse(string_view json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    int parse(const char* json, size_t len, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    int parse(const char* json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // the same, filling in stats for this call, which needs a build with JSON_STATS, see JsonStats.h
+    int parse(string_view json, Stats& stats, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // parse in place, json must outlive this Json and all its copies, see JsonValue::parse_insitu()
+    int parse_insitu(char* json, size_t len) noexcept;
+    // parse into a new arena-backed Document (see JsonDocument.h), the Json and all its copies share and keep alive that arena
+    int parse_document(string_view json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // parse a file through a read-only mapping, PARSE_FILE_ERROR when it cannot be opened
+    int parse_file(const string& path, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // see JsonValue::stringify() for exact_size
+    void stringify(string& str, bool exact_size = false) const noexcept;
+    // write through a buffered sink, so peak memory is one chunk instead of the whole text, see JsonSink.h
+    // return false if any write failed, the fd, FILE or ostream is neither flushed nor closed
+    bool stringify(Sink& sink) const noexcept;
+    bool stringify(int fd) const noexcept;
+    bool stringify(FILE* file) const noexcept;
+    bool stringify(ostream& os) const noexcept;
+    bool stringify(const CallbackSink::Callback& callback) const noexcept;
+    void stringify(string& str, Stats& stats, bool exact_size = false) const noexcept;
+    bool stringify(Sink& sink, Stats& stats) const noexcept;
+    // exact length of the stringified text, cached inside the tree, see JsonValue::get_stringify_size()
+    size_t get_stringify_size() const noexcept;
 
     // copy move swap function
     void copy(const Json& rhs) noexcept;
@@ -38,9 +71,14 @@ public:
     double get_number() const noexcept;
     void set_number(double n) noexcept;
 
-    const string& get_string() const noexcept;
+    // see JsonValue::get_string(), get_string_copy() gives the former const string& as a copy
+    string_view get_string() const noexcept;
+    string get_string_copy() const noexcept;
     size_t get_string_length() const noexcept;
-    void set_string(const string& str) noexcept;
+    void set_string(string_view str) noexcept;
+    // exact match for literals, as in JsonValue
+    void set_string(const char* str) noexcept;
+    void set_string(string&& str) noexcept;
 
     void set_array() noexcept;
     size_t get_array_size() const noexcept;
@@ -50,8 +88,10 @@ public:
     void clear_array() noexcept;
     const Json get_array_element(size_t index) const noexcept;
     void pushback_array_element(const Json& j) noexcept;
+    void pushback_array_element(Json&& j) noexcept;
     void popback_array_element() noexcept;
     void insert_array_element(size_t index, const Json& j) noexcept;
+    void insert_array_element(size_t index, Json&& j) noexcept;
     void erase_array_element(size_t index, size_t count) noexcept;
 
     void set_object() noexcept;
@@ -60,13 +100,44 @@ public:
     bool find_object_key(const string& key) const noexcept;
     const Json get_object_value(const string& key) const noexcept;
     void set_object_value(const string& key, const Json& val) noexcept;
+    void set_object_value(const string& key, Json&& val) noexcept;
     void remove_object_value(const string& key) noexcept;
 
+    // a view of the whole tree, it is valid while this Json (or a copy of it) is alive and not changed, see JsonRef.h
+    JsonRef get_ref() const noexcept;
+
 private:
     // create an smart ptr to JsonValue class, Json class provides API while JsonValue class takes charge of realization
     // shared ptr has a counter inside and release automatically when counter equals to 0, so all members can be destroyed without memory leak
+    // a child points at its node inside the tree but owns the whole tree, so the counter tells whether anyone else can see it
     shared_ptr<JsonValue> m_jv;
 
+    explicit Json(shared_ptr<JsonValue> jv) noexcept : m_jv(std::move(jv)) {}
+    // node and counter in one block from pmr::get_default_resource(), like the rest of the tree, see JsonAlloc.h
+    template <class... Args>
+    static shared_ptr<JsonValue> make_value(Args&&... args) noexcept {
+        return allocate_shared<JsonValue>(pmr::polymorphic_allocator<JsonValue>(), std::forward<Args>(args)...);
+    }
+
+    // steal the JsonValue behind rhs when nobody else shares it, otherwise fall back to share_value()
+    // both have to be done before mut(), so that rhs still counts as an owner when it belongs to this tree
+    JsonValue take_value(Json& rhs) const noexcept;
+    // a link to the value behind rhs, or a deep copy of it for a tree inside a Document
+    JsonValue share_value(const Json& rhs) const noexcept;
+    // nobody else shares the value, so it can be changed in place
+    bool unique() const noexcept;
+    // the tree lives in an arena made by parse_document(), links are never put into it, its root is not destroyed
+    bool in_document() const noexcept;
+    // the value to change in place, copied into a new node first when it is shared
+    // only the value itself is copied, its children become links, the tree around it stays with its other owners
+    JsonValue& mut() noexcept;
+    // same for a value which is about to be replaced as a whole, a shared one is not copied but left behind
+    JsonValue& fresh() noexcept;
+    // a handle to an element or member value of this tree as it is stored, a link gives a handle into the tree it points at
+    const Json child(const JsonValue& slot) const noexcept;
+
+    friend class JsonPublisher;
+
     // override for == and != operator
     friend bool operator==(const Json& lhs, const Json& rhs) noexcept;
     friend bool operator!=(const Json& lhs, const Json& rhs) noexcept;
@@ -75,6 +146,43 @@ private:
 bool operator==(const Json& lhs, const Json& rhs) noexcept;
 bool operator!=(const Json& lhs, const Json& rhs) noexcept;
 
+// one current root which writers replace atomically, readers get a snapshot which never changes under them
+// a reader does not wait for a writer, a writer builds the next root while readers keep using the old one
+//     JsonPublisher config(initial);
+//     Json snap = config.load();                        // reader thread
+//     config.update([](Json& j) { j.set_object_value("port", port); });   // writer thread
+class JsonPublisher {
+public:
+    JsonPublisher() noexcept;
+    explicit JsonPublisher(const Json& root) noexcept;
+
+    // the root published last, the snapshot shares it, so any change through it copies and is never seen by others
+    Json load() const noexcept;
+    void store(const Json& root) noexcept;
+    // publish desired only if expected is still the current root (the same tree, not an equal one)
+    bool compare_exchange(const Json& expected, const Json& desired) noexcept;
+
+    // change a snapshot of the current root with f(Json&) and publish it, f runs again if another writer got in between
+    // so f must only depend on the Json it is given
+    template <class F>
+    void update(F&& f) {
+        while (true) {
+            Json expected = load();
+            Json desired(expected);
+            f(desired);
+            if (compare_exchange(expected, desired)) return;
+        }
+    }
+
+private:
+    JsonPublisher(const JsonPublisher&) = delete;
+    JsonPublisher& operator=(const JsonPublisher&) = delete;
+
+private:
+    // only accessed through the atomic_load/atomic_store/atomic_compare_exchange functions for shared_ptr
+    shared_ptr<JsonValue> m_root;
+};
+
 };
 
 #endif
\ No newline at end of file
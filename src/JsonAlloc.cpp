@@ -0,0 +1,57 @@
+#include "JsonAlloc.h"
+
+namespace myJson {
+
+AllocCounts operator-(const AllocCounts& after, const AllocCounts& before) noexcept {
+    AllocCounts res;
+    res.allocs = after.allocs - before.allocs;
+    res.deallocs = after.deallocs - before.deallocs;
+    res.bytes = after.bytes - before.bytes;
+    res.freed_bytes = after.freed_bytes - before.freed_bytes;
+    return res;
+}
+
+TrackingResource::TrackingResource(pmr::memory_resource* upstream) noexcept
+    : m_upstream(upstream), m_allocs(0), m_deallocs(0), m_bytes(0), m_freed_bytes(0), m_peak(0) {}
+
+AllocCounts TrackingResource::get_counts() const noexcept {
+    AllocCounts res;
+    res.allocs = m_allocs.load(memory_order_relaxed);
+    res.deallocs = m_deallocs.load(memory_order_relaxed);
+    res.bytes = m_bytes.load(memory_order_relaxed);
+    res.freed_bytes = m_freed_bytes.load(memory_order_relaxed);
+    return res;
+}
+
+size_t TrackingResource::get_peak_bytes() const noexcept {
+    return m_peak.load(memory_order_relaxed);
+}
+
+void TrackingResource::reset_peak() noexcept {
+    m_peak.store(get_counts().live_bytes(), memory_order_relaxed);
+}
+
+void* TrackingResource::do_allocate(size_t bytes, size_t align) {
+    void* p = m_upstream->allocate(bytes, align);
+    m_allocs.fetch_add(1, memory_order_relaxed);
+    size_t total = m_bytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+    size_t freed = m_freed_bytes.load(memory_order_relaxed);
+    // with several threads the peak may miss a moment (or freed may already count later blocks), it is a statistic, not a limit
+    size_t live = total > freed ? total - freed : 0;
+    size_t peak = m_peak.load(memory_order_relaxed);
+    while (live > peak && !m_peak.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    return p;
+}
+
+void TrackingResource::do_deallocate(void* p, size_t bytes, size_t align) {
+    m_upstream->deallocate(p, bytes, align);
+    m_deallocs.fetch_add(1, memory_order_relaxed);
+    m_freed_bytes.fetch_add(bytes, memory_order_relaxed);
+}
+
+// memory of one tracker can only be given back through the same tracker
+bool TrackingResource::do_is_equal(const pmr::memory_resource& rhs) const noexcept {
+    return this == &rhs;
+}
+
+};
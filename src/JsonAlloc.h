@@ -0,0 +1,58 @@
+#ifndef JSON_ALLOC_H
+#define JSON_ALLOC_H
+#include <memory_resource>  // memory_resource
+#include <atomic>
+#include <cstddef>          // size_t
+
+using namespace std;
+
+namespace myJson {
+
+// everything a tree allocates goes through a pmr::memory_resource: strings, arrays and objects through the resource of
+// their JsonValue (pmr::get_default_resource() unless it lives in a Document), the JsonValue nodes behind Json and
+// Document arenas through pmr::get_default_resource(), so a TrackingResource installed there sees all of them
+
+// totals of a TrackingResource, they only grow, so after - before is what one operation cost
+struct AllocCounts {
+    size_t allocs = 0;
+    size_t deallocs = 0;
+    size_t bytes = 0;
+    size_t freed_bytes = 0;
+
+    size_t live_allocs() const noexcept { return allocs - deallocs; }
+    size_t live_bytes() const noexcept { return bytes - freed_bytes; }
+};
+
+AllocCounts operator-(const AllocCounts& after, const AllocCounts& before) noexcept;
+
+// counts every allocation and deallocation on its way to upstream, atomic so trees on several threads can share it
+// usually it is installed for the whole process, values keep a pointer to their resource, so it must outlive them:
+//     static TrackingResource tracker;
+//     pmr::set_default_resource(&tracker);
+class TrackingResource : public pmr::memory_resource {
+public:
+    explicit TrackingResource(pmr::memory_resource* upstream = pmr::new_delete_resource()) noexcept;
+
+    AllocCounts get_counts() const noexcept;
+    // most bytes alive at once since construction or the last reset_peak()
+    size_t get_peak_bytes() const noexcept;
+    void reset_peak() noexcept;
+    pmr::memory_resource* get_upstream() const noexcept { return m_upstream; }
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void* p, size_t bytes, size_t align) override;
+    bool do_is_equal(const pmr::memory_resource& rhs) const noexcept override;
+
+private:
+    pmr::memory_resource* m_upstream;
+    atomic<size_t> m_allocs;
+    atomic<size_t> m_deallocs;
+    atomic<size_t> m_bytes;
+    atomic<size_t> m_freed_bytes;
+    atomic<size_t> m_peak;
+};
+
+};
+
+#endif
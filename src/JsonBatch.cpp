@@ -0,0 +1,141 @@
+#include "JsonBatch.h"
+#include <cstring>  // memchr
+
+namespace myJson {
+
+// a block is the unit of stealing, small enough to balance uneven lines, large enough to keep the locks cold
+static const size_t BLOCK_LINES = 64;
+
+static bool is_blank(string_view line) noexcept {
+    for (char ch : line) {
+        if (ch != ' ' && ch != '\t' && ch != '\r') return false;
+    }
+    return true;
+}
+
+BatchParser::BatchParser(size_t threads) noexcept : m_generation(0), m_stop(false), m_remaining(0), m_records(nullptr),
+                                                    m_engine(ENGINE_RECURSIVE) {
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) {
+        m_queues.emplace_back(new Queue());
+    }
+    // thread 0 is the caller of parse_lines()
+    for (size_t i = 1; i < threads; ++i) {
+        m_threads.emplace_back(&BatchParser::run_worker, this, i);
+    }
+}
+
+BatchParser::~BatchParser() noexcept {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+size_t BatchParser::get_thread_count() const noexcept {
+    return m_queues.size();
+}
+
+void BatchParser::parse_lines(string_view text, vector<LineRecord>& records, PARSE_ENGINE engine) noexcept {
+    lock_guard<mutex> batch(m_batch_mutex);
+    // a json text never contains a raw '\n', so every '\n' is a record boundary, memchr finds them at memory speed
+    m_lines.clear();
+    records.clear();
+    const char* p = text.data();
+    const char* end = p + text.size();
+    for (size_t line = 1; p < end; ++line) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        if (nl == NULL) nl = end;
+        string_view sv(p, nl - p);
+        if (!sv.empty() && sv.back() == '\r') sv.remove_suffix(1);
+        if (!is_blank(sv)) {
+            m_lines.push_back(sv);
+            records.push_back(LineRecord{line, PARSE_OK, JsonValue()});
+        }
+        p = nl + 1;
+    }
+    if (m_lines.empty()) return;
+
+    // set before any block is queued, a worker still busy with stealing from the last batch may take one at once
+    size_t blocks = (m_lines.size() + BLOCK_LINES - 1) / BLOCK_LINES;
+    m_records = &records;
+    m_engine = engine;
+    m_remaining = blocks;
+
+    // each thread starts on a contiguous share, which keeps neighbouring records on the same core
+    size_t threads = m_queues.size();
+    for (size_t i = 0; i < threads; ++i) {
+        lock_guard<mutex> lock(m_queues[i]->m_mutex);
+        for (size_t b = blocks * i / threads; b < blocks * (i + 1) / threads; ++b) {
+            m_queues[i]->m_blocks.push_back(Block{b * BLOCK_LINES, min((b + 1) * BLOCK_LINES, m_lines.size())});
+        }
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    work(0);
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_remaining == 0; });
+}
+
+void BatchParser::run_worker(size_t id) noexcept {
+    size_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        work(id);
+    }
+}
+
+void BatchParser::work(size_t id) noexcept {
+    Block block;
+    while (take_block(id, block)) {
+        // each line is parsed in place, the parser stops at the end of the view
+        for (size_t i = block.first; i < block.last; ++i) {
+            LineRecord& record = (*m_records)[i];
+            record.ret = record.value.parse(m_lines[i], m_engine);
+        }
+        if (--m_remaining == 0) {
+            // lock so the caller cannot miss the notification between its check and its wait
+            lock_guard<mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+bool BatchParser::take_block(size_t id, Block& block) noexcept {
+    size_t threads = m_queues.size();
+    {
+        Queue& own = *m_queues[id];
+        lock_guard<mutex> lock(own.m_mutex);
+        if (!own.m_blocks.empty()) {
+            block = own.m_blocks.front();
+            own.m_blocks.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        Queue& victim = *m_queues[(id + i) % threads];
+        lock_guard<mutex> lock(victim.m_mutex);
+        if (!victim.m_blocks.empty()) {
+            block = victim.m_blocks.back();
+            victim.m_blocks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+};
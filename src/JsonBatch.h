@@ -0,0 +1,84 @@
+#ifndef JSON_BATCH_H
+#define JSON_BATCH_H
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>   // unique_ptr
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "JsonEnum.h"
+#include "JsonValue.h"
+
+using namespace std;
+
+namespace myJson {
+
+// one line of NDJSON (JSON Lines) text
+struct LineRecord {
+    // 1-based line number inside the parsed buffer
+    size_t line;
+    // PARSE_TYPE of this line, value is null when it is not PARSE_OK
+    int ret;
+    // a plain JsonValue, so creating the records on the calling thread does not allocate
+    JsonValue value;
+};
+
+// parses NDJSON buffers, every line on its own, on a pool of threads which is kept between batches
+// lines are cut into blocks, each thread starts with a contiguous share of them and steals from the others once its share is done
+class BatchParser {
+public:
+    // threads == 0 uses one thread per core, the calling thread always works as one of them
+    explicit BatchParser(size_t threads = 0) noexcept;
+    ~BatchParser() noexcept;
+
+    size_t get_thread_count() const noexcept;
+    // records are in line order, empty and whitespace-only lines are skipped, a trailing '\r' belongs to the line break
+    // notice that only one batch runs at a time, concurrent calls on the same BatchParser wait for each other
+    void parse_lines(string_view text, vector<LineRecord>& records, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+
+private:
+    BatchParser(const BatchParser&) = delete;
+    BatchParser& operator=(const BatchParser&) = delete;
+
+    // [first, last) of m_lines
+    struct Block {
+        size_t first;
+        size_t last;
+    };
+    // one deque per thread, the owner pops from the front, thieves from the back
+    struct Queue {
+        mutex m_mutex;
+        deque<Block> m_blocks;
+    };
+
+    void run_worker(size_t id) noexcept;
+    // parse blocks until no thread has any left
+    void work(size_t id) noexcept;
+    bool take_block(size_t id, Block& block) noexcept;
+
+private:
+    vector<unique_ptr<Queue>> m_queues;
+    vector<thread> m_threads;
+
+    // serializes parse_lines() callers
+    mutex m_batch_mutex;
+    // wakes the workers for a new batch (m_generation changed) or for shutdown
+    mutex m_mutex;
+    condition_variable m_start;
+    condition_variable m_done;
+    size_t m_generation;
+    bool m_stop;
+    // blocks not parsed yet in the current batch
+    atomic<size_t> m_remaining;
+
+    // the current batch, lines are views into the caller's text
+    vector<string_view> m_lines;
+    vector<LineRecord>* m_records;
+    PARSE_ENGINE m_engine;
+};
+
+};
+
+#endif
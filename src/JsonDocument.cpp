@@ -0,0 +1,41 @@
+#include "JsonDocument.h"
+
+namespace myJson {
+
+// monotonic_buffer_resource requires a positive initial size
+Document::Document(size_t initial_size) noexcept : m_arena(initial_size > 0 ? initial_size : 4096), m_fresh(true) {
+    make_root();
+}
+
+void Document::make_root() noexcept {
+    void* p = m_arena.allocate(sizeof(JsonValue), alignof(JsonValue));
+    m_root = new(p) JsonValue(JsonValue::allocator_type(&m_arena));
+}
+
+int Document::parse(string_view json, PARSE_ENGINE engine) noexcept {
+    if (!m_fresh) clear();
+    m_fresh = false;
+    return m_root->parse(json, engine);
+}
+
+int Document::parse_insitu(char* json, size_t len) noexcept {
+    if (!m_fresh) clear();
+    m_fresh = false;
+    return m_root->parse_insitu(json, len);
+}
+
+JsonValue& Document::get_root() noexcept {
+    return *m_root;
+}
+
+const JsonValue& Document::get_root() const noexcept {
+    return *m_root;
+}
+
+void Document::clear() noexcept {
+    m_arena.release();
+    make_root();
+    m_fresh = true;
+}
+
+};
@@ -0,0 +1,38 @@
+#ifndef JSON_DOCUMENT_H
+#define JSON_DOCUMENT_H
+#include "JsonValue.h"
+
+namespace myJson {
+
+// Document owns a monotonic arena, the root value and every node, string and container below it are allocated from it
+// deallocation inside the arena does nothing, so destroying a Document releases the whole tree at once without walking it
+class Document {
+public:
+    // initial_size is the first arena block, later blocks grow geometrically
+    explicit Document(size_t initial_size = 0) noexcept;
+    // notice that the dtor of m_root is skipped on purpose, m_arena gives back all blocks by itself
+    ~Document() noexcept {}
+    // drop the current tree and all arena blocks, then parse json into a fresh root
+    int parse(string_view json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // same as parse(), but strings and keys point into json, which must outlive the tree, see JsonValue::parse_insitu()
+    int parse_insitu(char* json, size_t len) noexcept;
+    JsonValue& get_root() noexcept;
+    const JsonValue& get_root() const noexcept;
+    void clear() noexcept;
+
+private:
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+    void make_root() noexcept;
+
+private:
+    pmr::monotonic_buffer_resource m_arena;
+    // placed inside m_arena, values copied out of it use the global heap, values moved out still point into it
+    JsonValue* m_root;
+    // nothing was parsed into m_arena since it was last released, so the first block need not be given back and taken again
+    bool m_fresh;
+};
+
+};
+
+#endif
@@ -29,7 +29,19 @@ namespace myJson {
         PARSE_MISS_COMMA_OR_SQUARE_BRACKET,
         PARSE_MISS_KEY,
         PARSE_MISS_COLON,
-        PARSE_MISS_COMMA_OR_CURLY_BRACKET
+        PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+        // a handler of GenericParser returned false, see JsonParser.h
+        PARSE_ABORTED,
+        // parse_file() could not open or map the file
+        PARSE_FILE_ERROR
+    };
+
+    // parse engines, both build the same tree and return the same PARSE_TYPE for any input
+    enum PARSE_ENGINE {
+        // recursive descent over the text, one byte at a time
+        ENGINE_RECURSIVE = 0,
+        // stage 1 indexes all structural chars with SIMD, stage 2 walks that index (see JsonSimd.h)
+        ENGINE_STAGED
     };
 
 }
@@ -0,0 +1,80 @@
+#include "JsonFile.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define JSON_HAS_MMAP 1
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace myJson {
+
+#ifdef JSON_HAS_MMAP
+
+MappedFile::MappedFile(const string& path) noexcept : m_data(""), m_size(0), m_mapped(0), m_open(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+    m_size = st.st_size;
+    if (m_size == 0) {
+        close(fd);
+        m_open = true;
+        return;
+    }
+    void* base = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    // the mapping keeps its own reference to the file
+    close(fd);
+    // Parser reads front to back once, so the kernel may read ahead aggressively and drop pages behind
+    madvise(base, m_size, MADV_SEQUENTIAL);
+    m_data = (const char*)base;
+    m_mapped = m_size;
+    m_open = true;
+}
+
+MappedFile::~MappedFile() noexcept {
+    if (m_mapped != 0) {
+        munmap((void*)m_data, m_mapped);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const string& path) noexcept : m_data(""), m_size(0), m_mapped(0), m_open(false) {
+    ifstream in(path, ios::binary);
+    if (!in) return;
+    ostringstream ss;
+    ss << in.rdbuf();
+    m_buf = ss.str();
+    m_data = m_buf.c_str();
+    m_size = m_buf.size();
+    m_open = true;
+}
+
+MappedFile::~MappedFile() noexcept {}
+
+#endif
+
+bool MappedFile::is_open() const noexcept {
+    return m_open;
+}
+
+const char* MappedFile::data() const noexcept {
+    return m_data;
+}
+
+size_t MappedFile::size() const noexcept {
+    return m_size;
+}
+
+};
@@ -0,0 +1,39 @@
+#ifndef JSON_FILE_H
+#define JSON_FILE_H
+#include <string>
+#include <cstddef>  // size_t
+
+using namespace std;
+
+namespace myJson {
+
+// a whole file mapped read-only, so Parser can read it in place
+// notice that the file must not be truncated while it is mapped, reading a page which is gone raises SIGBUS
+// without mmap (non-POSIX systems) the file is simply read into memory
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) noexcept;
+    ~MappedFile() noexcept;
+
+    // false when the file could not be opened, read or mapped
+    bool is_open() const noexcept;
+    const char* data() const noexcept;
+    size_t size() const noexcept;
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    const char* m_data;
+    size_t m_size;
+    // 0 when nothing is mapped
+    size_t m_mapped;
+    bool m_open;
+    // used instead of the mapping when mmap is not available
+    string m_buf;
+};
+
+};
+
+#endif
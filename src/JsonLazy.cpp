@@ -0,0 +1,271 @@
+#include "JsonLazy.h"
+#include "JsonParser.h"
+#include "JsonSimd.h"
+#include "JsonNumber.h"
+#include <cmath>    // HUGE_VAL
+#include <cstring>  // strlen
+
+namespace myJson {
+
+// nothing at or behind end is read, the text needs no '\0' terminator
+static inline const char* skip_ws(const char* p, const char* end) {
+    if (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p = skip_whitespace(p + 1, end);
+    }
+    return p;
+}
+
+// bytes which may follow a number or a literal
+static inline bool ends_scalar(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == ',' || ch == ']' || ch == '}' || ch == ':';
+}
+
+// the byte at p is ch, false at the end of the text
+static inline bool at(const char* p, const char* end, char ch) {
+    return p < end && *p == ch;
+}
+
+static inline bool match_literal(const char* p, const char* end, const char* literal) {
+    while (*literal != '\0') {
+        if (p == end || *p++ != *literal++) return false;
+    }
+    return true;
+}
+
+// only the first byte (whole literal for null/true/false) is checked, the rest is left to the conversion functions
+static int check_token(const char* p, const char* end) {
+    if (p == end) return PARSE_EXPECT_VALUE;
+    switch (*p) {
+        case 'n' : return match_literal(p, end, "null") ? PARSE_OK : PARSE_INVALID_VALUE;
+        case 't' : return match_literal(p, end, "true") ? PARSE_OK : PARSE_INVALID_VALUE;
+        case 'f' : return match_literal(p, end, "false") ? PARSE_OK : PARSE_INVALID_VALUE;
+        case '\"' : case '[' : case '{' : case '-' :
+        case '0' : case '1' : case '2' : case '3' : case '4' :
+        case '5' : case '6' : case '7' : case '8' : case '9' :
+            return PARSE_OK;
+        default : return PARSE_INVALID_VALUE;
+    }
+}
+
+// p is at the opening quote, return behind the closing one or NULL
+static const char* skip_string(const char* p, const char* end) {
+    ++p;
+    while (true) {
+        p = scan_string(p, end);
+        if (p == end) return NULL;
+        if (*p == '\"') return p + 1;
+        // a raw control char, or a backslash at the very end
+        if (*p != '\\' || p + 1 == end) return NULL;
+        p += 2;
+    }
+}
+
+// bracket matching only counts the depth and steps over strings, nothing in between is validated or allocated
+static const char* skip_value(const char* p, const char* end) {
+    if (p == end) return NULL;
+    if (*p == '\"') return skip_string(p, end);
+    if (*p == '[' || *p == '{') {
+        size_t depth = 0;
+        while (p < end) {
+            switch (*p) {
+                case '[' : case '{' :
+                    ++depth;
+                    ++p;
+                    break;
+                case ']' : case '}' :
+                    ++p;
+                    if (--depth == 0) return p;
+                    break;
+                case '\"' :
+                    if ((p = skip_string(p, end)) == NULL) return NULL;
+                    break;
+                default :
+                    ++p;
+            }
+        }
+        return NULL;
+    }
+    const char* q = p;
+    while (q < end && !ends_scalar(*q)) ++q;
+    return q;
+}
+
+// p is at the value of one element/member, move it to the next one, more is false when close was reached instead
+static int next_element(const char*& p, const char* end, char close, int miss, bool& more) {
+    const char* q = skip_value(p, end);
+    if (q == NULL) return at(p, end, '\"') ? PARSE_MISS_QUOTATION_MARK : miss;
+    p = skip_ws(q, end);
+    if (at(p, end, ',')) {
+        p = skip_ws(p + 1, end);
+        more = true;
+        return PARSE_OK;
+    }
+    if (at(p, end, close)) {
+        more = false;
+        return PARSE_OK;
+    }
+    return miss;
+}
+
+// p is at a key, move it to the value and return the key with its quotes in [key, key_end)
+static int next_member(const char*& p, const char* end, const char*& key, const char*& key_end) {
+    if (!at(p, end, '\"')) return PARSE_MISS_KEY;
+    key = p;
+    if ((key_end = skip_string(p, end)) == NULL) return PARSE_MISS_QUOTATION_MARK;
+    p = skip_ws(key_end, end);
+    if (!at(p, end, ':')) return PARSE_MISS_COLON;
+    p = skip_ws(p + 1, end);
+    return check_token(p, end);
+}
+
+// only the string event is needed to decode one string
+struct StringHandler : BaseHandler {
+    explicit StringHandler(JsonValue::String& str) noexcept : m_str(str) {}
+    bool on_string(string_view str) noexcept {
+        m_str.assign(str.data(), str.size());
+        return true;
+    }
+    JsonValue::String& m_str;
+};
+
+// compare the quoted key text [key, key_end) with target
+static bool key_equals(const char* key, const char* key_end, string_view target, const char* end) {
+    string_view raw(key + 1, key_end - key - 2);
+    if (raw.find('\\') == string_view::npos) return raw == target;
+    // escaped keys are rare, only they pay for decoding
+    JsonValue::String tmp;
+    StringHandler handler(tmp);
+    GenericParser<StringHandler> p(handler, key, end);
+    return p.parse_prefix() == PARSE_OK && string_view(tmp) == target;
+}
+
+// define all functions declared in LazyValue class
+LazyValue::LazyValue(const string& json) noexcept : LazyValue(json.c_str(), json.c_str() + json.size()) {}
+
+LazyValue::LazyValue(const char* json) noexcept : LazyValue(json, json + strlen(json)) {}
+
+LazyValue::LazyValue(const char* json, const char* end) noexcept : m_json(skip_ws(json, end)), m_end(end) {
+    m_err = check_token(m_json, m_end);
+}
+
+LazyValue::LazyValue(const char* json, const char* end, int err) noexcept : m_json(json), m_end(end), m_err(err) {}
+
+int LazyValue::get_error() const noexcept {
+    return m_err;
+}
+
+JSON_TYPE LazyValue::get_type() const noexcept {
+    if (m_err != PARSE_OK) return JSON_NULL;
+    switch (*m_json) {
+        case 'n' : return JSON_NULL;
+        case 't' : return JSON_TRUE;
+        case 'f' : return JSON_FALSE;
+        case '\"' : return JSON_STRING;
+        case '[' : return JSON_ARRAY;
+        case '{' : return JSON_OBJECT;
+        default : return JSON_NUMBER;
+    }
+}
+
+int LazyValue::get_number(double& d) const noexcept {
+    if (m_err != PARSE_OK) return m_err;
+    DecimalNumber num;
+    const char* p = scan_number(m_json, m_end, num);
+    if (p == NULL || (p != m_end && !ends_scalar(*p))) return PARSE_INVALID_VALUE;
+    double tmp = decimal_to_double(num);
+    if (tmp == HUGE_VAL || tmp == -HUGE_VAL) return PARSE_NUMBER_TOO_BIG;
+    d = tmp;
+    return PARSE_OK;
+}
+
+int LazyValue::get_string(JsonValue::String& str) const noexcept {
+    if (m_err != PARSE_OK) return m_err;
+    if (*m_json != '\"') return PARSE_INVALID_VALUE;
+    StringHandler handler(str);
+    GenericParser<StringHandler> p(handler, m_json, m_end);
+    return p.parse_prefix();
+}
+
+int LazyValue::get_value(JsonValue& jv) const noexcept {
+    if (m_err != PARSE_OK) {
+        jv.set_type(JSON_NULL);
+        return m_err;
+    }
+    DomHandler handler(jv);
+    Parser p(handler, m_json, m_end);
+    int ret = p.parse_prefix();
+    if (ret != PARSE_OK) {
+        jv.set_type(JSON_NULL);
+    }
+    return ret;
+}
+
+size_t LazyValue::get_array_size() const noexcept {
+    if (m_err != PARSE_OK || *m_json != '[') return 0;
+    const char* p = skip_ws(m_json + 1, m_end);
+    if (at(p, m_end, ']')) return 0;
+    size_t size = 0;
+    bool more = true;
+    while (more) {
+        if (check_token(p, m_end) != PARSE_OK) return 0;
+        if (next_element(p, m_end, ']', PARSE_MISS_COMMA_OR_SQUARE_BRACKET, more) != PARSE_OK) return 0;
+        ++size;
+    }
+    return size;
+}
+
+size_t LazyValue::get_object_size() const noexcept {
+    if (m_err != PARSE_OK || *m_json != '{') return 0;
+    const char* p = skip_ws(m_json + 1, m_end);
+    if (at(p, m_end, '}')) return 0;
+    size_t size = 0;
+    bool more = true;
+    const char *key, *key_end;
+    while (more) {
+        if (next_member(p, m_end, key, key_end) != PARSE_OK) return 0;
+        if (next_element(p, m_end, '}', PARSE_MISS_COMMA_OR_CURLY_BRACKET, more) != PARSE_OK) return 0;
+        ++size;
+    }
+    return size;
+}
+
+LazyValue LazyValue::get_array_element(size_t index) const noexcept {
+    if (m_err != PARSE_OK) return *this;
+    if (*m_json != '[') return LazyValue(m_json, m_end, PARSE_INVALID_VALUE);
+    const char* p = skip_ws(m_json + 1, m_end);
+    if (at(p, m_end, ']')) return LazyValue(p, m_end, PARSE_EXPECT_VALUE);
+    bool more = true;
+    int ret;
+    for (size_t i = 0; more; ++i) {
+        if ((ret = check_token(p, m_end)) != PARSE_OK) return LazyValue(p, m_end, ret);
+        if (i == index) return LazyValue(p, m_end, PARSE_OK);
+        if ((ret = next_element(p, m_end, ']', PARSE_MISS_COMMA_OR_SQUARE_BRACKET, more)) != PARSE_OK) {
+            return LazyValue(p, m_end, ret);
+        }
+    }
+    return LazyValue(p, m_end, PARSE_EXPECT_VALUE);
+}
+
+bool LazyValue::find_object_key(string_view key) const noexcept {
+    return get_object_value(key).get_error() == PARSE_OK;
+}
+
+LazyValue LazyValue::get_object_value(string_view key) const noexcept {
+    if (m_err != PARSE_OK) return *this;
+    if (*m_json != '{') return LazyValue(m_json, m_end, PARSE_INVALID_VALUE);
+    const char* p = skip_ws(m_json + 1, m_end);
+    if (at(p, m_end, '}')) return LazyValue(p, m_end, PARSE_EXPECT_VALUE);
+    bool more = true;
+    int ret;
+    const char *k, *k_end;
+    while (more) {
+        if ((ret = next_member(p, m_end, k, k_end)) != PARSE_OK) return LazyValue(p, m_end, ret);
+        if (key_equals(k, k_end, key, m_end)) return LazyValue(p, m_end, PARSE_OK);
+        if ((ret = next_element(p, m_end, '}', PARSE_MISS_COMMA_OR_CURLY_BRACKET, more)) != PARSE_OK) {
+            return LazyValue(p, m_end, ret);
+        }
+    }
+    return LazyValue(p, m_end, PARSE_EXPECT_VALUE);
+}
+
+};
@@ -0,0 +1,59 @@
+#ifndef JSON_LAZY_H
+#define JSON_LAZY_H
+#include <string>
+#include <string_view>
+#include "JsonEnum.h"
+#include "JsonValue.h"
+
+using namespace std;
+
+namespace myJson {
+
+// LazyValue is a cursor into json text, it never builds a tree and never allocates while navigating
+// walking into a key or an index only reads the text up to there, values in between are skipped by bracket matching
+// notice that skipped values are not validated, and the text must outlive every LazyValue pointing into it
+class LazyValue {
+public:
+    // the root value of json, only the first token is checked here
+    explicit LazyValue(const string& json) noexcept;
+    // the cursor points into the text, so a temporary would be gone before the first access
+    LazyValue(string&& json) = delete;
+    // a '\0' terminated text, e.g. a literal
+    explicit LazyValue(const char* json) noexcept;
+    // [json, end) is the whole text, nothing at or behind end is ever read, so it needs no '\0' terminator
+    LazyValue(const char* json, const char* end) noexcept;
+
+    // PARSE_OK, or the error found while getting here, a missing key or index gives PARSE_EXPECT_VALUE
+    int get_error() const noexcept;
+    // type of the first token, JSON_NULL when get_error() is not PARSE_OK
+    JSON_TYPE get_type() const noexcept;
+
+    // conversions only happen on access, each one returns a PARSE_TYPE
+    int get_number(double& d) const noexcept;
+    int get_string(JsonValue::String& str) const noexcept;
+    // build the whole subtree of this value, text behind it is not looked at
+    int get_value(JsonValue& jv) const noexcept;
+
+    // count by skipping over the elements, 0 for other types or invalid text
+    size_t get_array_size() const noexcept;
+    size_t get_object_size() const noexcept;
+    LazyValue get_array_element(size_t index) const noexcept;
+    // the first member with key is found, unlike JsonValue where a later duplicated key overwrites the former one
+    // asking an element or member of another type gives PARSE_INVALID_VALUE
+    bool find_object_key(string_view key) const noexcept;
+    LazyValue get_object_value(string_view key) const noexcept;
+
+private:
+    LazyValue(const char* json, const char* end, int err) noexcept;
+
+private:
+    // first byte of the value, leading whitespace is already skipped
+    const char* m_json;
+    // end of the whole text, every read checks it first
+    const char* m_end;
+    int m_err;
+};
+
+};
+
+#endif
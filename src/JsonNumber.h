@@ -0,0 +1,38 @@
+#ifndef JSON_NUMBER_H
+#define JSON_NUMBER_H
+#include <cstdint>  // uint64_t, int64_t
+
+namespace myJson {
+
+// a decimal number scanned from json text, its value is (-1)^negative * w * 10^exponent
+struct DecimalNumber {
+    bool negative;
+    // first 19 significant digits, truncated is set when more digits follow
+    uint64_t w;
+    int64_t exponent;
+    bool truncated;
+    // whole number text, only read again when w cannot decide the rounding by itself
+    const char* begin;
+    const char* end;
+};
+
+// validate number grammar in [p, end) and collect its digits in one pass, i.e. https://github.com/miloyip/json-tutorial/blob/master/tutorial02/images/number.png
+// return the first char behind the number, or NULL if p does not start a valid number
+const char* scan_number(const char* p, const char* end, DecimalNumber& num) noexcept;
+
+// correctly rounded (round half to even) conversion which never depends on the current locale
+// an overflow returns +/-HUGE_VAL and a too small value returns +/-0.0, same as strtod
+double decimal_to_double(const DecimalNumber& num) noexcept;
+// Clinger's fast path, w and 10^|exponent| are both exact doubles, so one IEEE operation rounds correctly
+// everything else needs Eisel-Lemire, and a few of those the big decimal fallback
+inline bool is_fast_number(const DecimalNumber& num) noexcept {
+    return !num.truncated && num.exponent >= -22 && num.exponent <= 22 && num.w <= (1ULL << 53);
+}
+
+// format a finite d with the fewest digits that still parse back to exactly d, e.g. 0.1 instead of 0.10000000000000001
+// the layout is the same as printf("%.17g"), buf needs room for 25 chars, no '\0' is appended, return the end of written chars
+char* double_to_chars(double d, char* buf) noexcept;
+
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "JsonObject.h"
+#include "JsonValue.h"
+#include <cassert>
+#include <functional>   // hash
+#include <tuple>        // forward_as_tuple
+
+namespace myJson {
+
+JsonKey& JsonKey::operator=(const JsonKey& rhs) noexcept {
+    if (this != &rhs) {
+        m_str.assign(rhs.view());
+        m_view = string_view();
+    }
+    return *this;
+}
+
+JsonKey& JsonKey::operator=(JsonKey&& rhs) noexcept {
+    if (this != &rhs) {
+        m_str = std::move(rhs.m_str);
+        m_view = rhs.m_view;
+    }
+    return *this;
+}
+
+JsonKey JsonKey::borrow(string_view key) noexcept {
+    JsonKey res;
+    res.m_view = key;
+    // an empty view of a literal may still have a null data(), any non-null pointer marks it as borrowed
+    if (key.data() == nullptr) res.m_view = string_view("", 0);
+    return res;
+}
+
+// define all functions declared in JsonObject.h, they need JsonValue to be complete
+// ctor dtor cctor rvalue etc
+JsonObject::JsonObject() noexcept {}
+
+JsonObject::JsonObject(const allocator_type& alloc) noexcept : m_members(alloc), m_index(alloc) {}
+
+JsonObject::~JsonObject() noexcept {}
+
+JsonObject::JsonObject(const JsonObject& rhs) noexcept : m_members(rhs.m_members), m_index(rhs.m_index) {}
+
+JsonObject::JsonObject(const JsonObject& rhs, const allocator_type& alloc) noexcept
+    : m_members(rhs.m_members, alloc), m_index(rhs.m_index, alloc) {}
+
+JsonObject::JsonObject(JsonObject&& rhs) noexcept
+    : m_members(std::move(rhs.m_members)), m_index(std::move(rhs.m_index)) {
+    rhs.clear();
+}
+
+// with different resources members are moved one by one, clear rhs so that it never keeps moved-from keys
+JsonObject::JsonObject(JsonObject&& rhs, const allocator_type& alloc) noexcept
+    : m_members(std::move(rhs.m_members), alloc), m_index(std::move(rhs.m_index), alloc) {
+    rhs.clear();
+}
+
+JsonObject& JsonObject::operator=(const JsonObject& rhs) noexcept = default;
+
+JsonObject& JsonObject::operator=(JsonObject&& rhs) noexcept {
+    if (this != &rhs) {
+        m_members = std::move(rhs.m_members);
+        m_index = std::move(rhs.m_index);
+        rhs.clear();
+    }
+    return *this;
+}
+
+JsonObject::allocator_type JsonObject::get_allocator() const noexcept {
+    return m_members.get_allocator();
+}
+
+size_t JsonObject::size() const noexcept {
+    return m_members.size();
+}
+
+size_t JsonObject::capacity() const noexcept {
+    return m_members.capacity();
+}
+
+bool JsonObject::empty() const noexcept {
+    return m_members.empty();
+}
+
+void JsonObject::clear() noexcept {
+    m_members.clear();
+    m_index.clear();
+}
+
+JsonObject::const_iterator JsonObject::begin() const noexcept {
+    return m_members.begin();
+}
+
+JsonObject::const_iterator JsonObject::end() const noexcept {
+    return m_members.end();
+}
+
+const JsonObject::Member& JsonObject::operator[](size_t index) const noexcept {
+    assert(index < m_members.size());
+    return m_members[index];
+}
+
+JsonValue& JsonObject::value(size_t index) noexcept {
+    assert(index < m_members.size());
+    return m_members[index].second;
+}
+
+size_t JsonObject::find(string_view key) const noexcept {
+    if (m_index.empty()) {
+        // most objects have only a few keys, comparing them in order is cheaper than hashing
+        for (size_t i = 0; i < m_members.size(); ++i) {
+            if (m_members[i].first.view() == key) return i;
+        }
+        return npos;
+    }
+    return find(key, hash_key(key));
+}
+
+size_t JsonObject::find(string_view key, size_t hash) const noexcept {
+    if (m_index.empty()) return find(key);
+    size_t mask = m_index.size() - 1;
+    for (size_t i = hash & mask; m_index[i].pos != 0; i = (i + 1) & mask) {
+        const Slot& slot = m_index[i];
+        if (slot.hash == (uint32_t)hash && m_members[slot.pos - 1].first.view() == key) {
+            return slot.pos - 1;
+        }
+    }
+    return npos;
+}
+
+JsonValue& JsonObject::insert(string_view key) noexcept {
+    size_t index = find(key);
+    if (index != npos) return m_members[index].second;
+    return append(JsonKey(key, get_allocator()));
+}
+
+JsonValue& JsonObject::insert(pmr::string&& key) noexcept {
+    size_t index = find(key);
+    if (index != npos) return m_members[index].second;
+    return append(JsonKey(std::move(key), get_allocator()));
+}
+
+JsonValue& JsonObject::insert_borrowed(string_view key) noexcept {
+    size_t index = find(key);
+    if (index != npos) return m_members[index].second;
+    return append(JsonKey::borrow(key));
+}
+
+void JsonObject::erase(size_t index) noexcept {
+    assert(index < m_members.size());
+    m_members.erase(m_members.begin() + index);
+    // positions behind index all shift by one, simply drop or rebuild the whole index
+    if (!m_index.empty()) {
+        if (m_members.size() > INDEX_THRESHOLD) build_index();
+        else m_index.clear();
+    }
+}
+
+void JsonObject::assign_keys(const JsonObject& rhs) noexcept {
+    m_members.clear();
+    m_members.reserve(rhs.size());
+    for (const auto& member : rhs.m_members) {
+        // uses-allocator construction passes our resource to both the key and the value
+        m_members.emplace_back(piecewise_construct, forward_as_tuple(member.first), forward_as_tuple());
+    }
+    m_index = rhs.m_index;
+}
+
+size_t JsonObject::hash_key(string_view key) noexcept {
+    return hash<string_view>()(key);
+}
+
+JsonValue& JsonObject::append(JsonKey&& key) noexcept {
+    m_members.emplace_back(piecewise_construct, forward_as_tuple(std::move(key)), forward_as_tuple());
+    if (m_index.empty()) {
+        if (m_members.size() > INDEX_THRESHOLD) build_index();
+    } else if (m_members.size() * 2 > m_index.size()) {
+        build_index();
+    } else {
+        index_member(m_members.size() - 1, hash_key(m_members.back().first.view()));
+    }
+    return m_members.back().second;
+}
+
+void JsonObject::build_index() noexcept {
+    size_t capacity = 2 * INDEX_THRESHOLD;
+    while (capacity < m_members.size() * 4) capacity <<= 1;
+    m_index.assign(capacity, Slot{0, 0});
+    for (size_t i = 0; i < m_members.size(); ++i) {
+        index_member(i, hash_key(m_members[i].first.view()));
+    }
+}
+
+void JsonObject::index_member(size_t index, size_t hash) noexcept {
+    size_t mask = m_index.size() - 1;
+    size_t i = hash & mask;
+    while (m_index[i].pos != 0) i = (i + 1) & mask;
+    m_index[i].hash = (uint32_t)hash;
+    m_index[i].pos = (uint32_t)(index + 1);
+}
+
+};
@@ -0,0 +1,111 @@
+#ifndef JSON_OBJECT_H
+#define JSON_OBJECT_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>          // pair
+#include <cstdint>          // uint32_t
+#include <memory_resource>  // pmr containers
+
+using namespace std;
+
+namespace myJson {
+
+// forward declaration, JsonObject is a member of the union inside JsonValue
+class JsonValue;
+
+// key of a member, normally it owns a copy of its chars, after an in-situ parse it only points into the caller's text
+class JsonKey {
+public:
+    using allocator_type = pmr::polymorphic_allocator<char>;
+
+    explicit JsonKey(const allocator_type& alloc = allocator_type()) noexcept : m_str(alloc) {}
+    JsonKey(string_view key, const allocator_type& alloc) noexcept : m_str(key, alloc) {}
+    JsonKey(pmr::string&& key, const allocator_type& alloc) noexcept : m_str(std::move(key), alloc) {}
+    // copies always own their chars, so a copied object never depends on the text
+    JsonKey(const JsonKey& rhs) noexcept : m_str(rhs.view()) {}
+    JsonKey(const JsonKey& rhs, const allocator_type& alloc) noexcept : m_str(rhs.view(), alloc) {}
+    JsonKey(JsonKey&& rhs) noexcept : m_str(std::move(rhs.m_str)), m_view(rhs.m_view) {}
+    JsonKey(JsonKey&& rhs, const allocator_type& alloc) noexcept : m_str(std::move(rhs.m_str), alloc), m_view(rhs.m_view) {}
+    JsonKey& operator=(const JsonKey& rhs) noexcept;
+    JsonKey& operator=(JsonKey&& rhs) noexcept;
+
+    // the chars are not copied, they must outlive the key
+    static JsonKey borrow(string_view key) noexcept;
+
+    string_view view() const noexcept { return m_view.data() != nullptr ? m_view : string_view(m_str); }
+    operator string_view() const noexcept { return view(); }
+
+private:
+    pmr::string m_str;
+    // data() is nullptr unless the key is borrowed, m_str stays empty then
+    string_view m_view;
+};
+
+// flat storage for JSON_OBJECT, all [key, val] members stay in one contiguous vector in insertion order
+// small objects are found by a linear scan, a side hash index is only built once an object grows past INDEX_THRESHOLD
+class JsonObject {
+public:
+    using allocator_type = pmr::polymorphic_allocator<char>;
+    using Member = pair<JsonKey, JsonValue>;
+    using const_iterator = pmr::vector<Member>::const_iterator;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr size_t INDEX_THRESHOLD = 16;
+
+    // ctor dtor cctor rvalue etc, the allocator-extended versions make JsonObject work as a pmr member like other containers
+    JsonObject() noexcept;
+    explicit JsonObject(const allocator_type& alloc) noexcept;
+    ~JsonObject() noexcept;
+    JsonObject(const JsonObject& rhs) noexcept;
+    JsonObject(const JsonObject& rhs, const allocator_type& alloc) noexcept;
+    JsonObject(JsonObject&& rhs) noexcept;
+    JsonObject(JsonObject&& rhs, const allocator_type& alloc) noexcept;
+    JsonObject& operator=(const JsonObject& rhs) noexcept;
+    JsonObject& operator=(JsonObject&& rhs) noexcept;
+
+    allocator_type get_allocator() const noexcept;
+
+    size_t size() const noexcept;
+    // members which fit before the next growth
+    size_t capacity() const noexcept;
+    bool empty() const noexcept;
+    void clear() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+    const Member& operator[](size_t index) const noexcept;
+    JsonValue& value(size_t index) noexcept;
+
+    // return position of key, or npos when it does not exist, hash must be hash_key(key) if it is given
+    size_t find(string_view key) const noexcept;
+    size_t find(string_view key, size_t hash) const noexcept;
+    // return the value slot of key, a JSON_NULL one is appended when key does not exist yet
+    JsonValue& insert(string_view key) noexcept;
+    JsonValue& insert(pmr::string&& key) noexcept;
+    // same as insert(), but a new key only points at the chars of key, used by in-situ parsing
+    JsonValue& insert_borrowed(string_view key) noexcept;
+    void erase(size_t index) noexcept;
+    // the keys (and index) of rhs with JSON_NULL values, replacing all members, value(i) fills them in
+    void assign_keys(const JsonObject& rhs) noexcept;
+
+    static size_t hash_key(string_view key) noexcept;
+
+private:
+    // one open addressing slot of the hash index, pos is index + 1 of the member so that 0 marks an empty slot
+    struct Slot {
+        uint32_t hash;
+        uint32_t pos;
+    };
+
+    void build_index() noexcept;
+    void index_member(size_t index, size_t hash) noexcept;
+    JsonValue& append(JsonKey&& key) noexcept;
+
+private:
+    pmr::vector<Member> m_members;
+    // empty until size() > INDEX_THRESHOLD, then kept at no more than half load
+    pmr::vector<Slot> m_index;
+};
+
+};
+
+#endif
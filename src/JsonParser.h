@@ -1,40 +1,575 @@
 #ifndef JSON_PARSER_H
 #define JSON_PARSER_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cassert>  // assert()
+#include <cmath>    // HUGE_VAL
+#include <cstdint>  // uint32_t
+#include <cstring>  // memcpy
+#include <algorithm>    // max
+#include <chrono>
+#include "JsonEnum.h"
 #include "JsonValue.h"
+#include "JsonSimd.h"
+#include "JsonNumber.h"
+#include "JsonStats.h"
+
+using namespace std;
 
 namespace myJson {
 
-class Parser {
+// events sent by GenericParser in document order, every one of them returns false to stop parsing with PARSE_ABORTED
+// a handler is any class with these members, deriving from BaseHandler and hiding only the needed ones is enough
+// string_view arguments point into the text or into a scratch buffer of the parser, copy them if they must live longer
+// nothing is allocated by the parser itself, except that escaped strings longer than SSO grow one reused buffer
+struct BaseHandler {
+    bool on_null() noexcept { return true; }
+    bool on_bool(bool) noexcept { return true; }
+    bool on_number(double) noexcept { return true; }
+    bool on_string(string_view) noexcept { return true; }
+    bool on_start_array() noexcept { return true; }
+    // count is the number of elements/members of the container just closed
+    bool on_end_array(size_t) noexcept { return true; }
+    bool on_start_object() noexcept { return true; }
+    bool on_key(string_view) noexcept { return true; }
+    bool on_end_object(size_t) noexcept { return true; }
+};
+
+// builds a JsonValue tree, every value is created directly in its final slot inside the parent container
+// with insitu, strings and keys only point at the views they come with, which GenericParser::parse_insitu() keeps inside the text
+class DomHandler {
+public:
+    explicit DomHandler(JsonValue& root, bool insitu = false) noexcept
+        : m_root(root), m_member(nullptr), m_insitu(insitu), m_allocs(0) {
+        m_stack.reserve(16);
+    }
+
+    bool on_null() noexcept { slot().set_type(JSON_NULL); return true; }
+    bool on_bool(bool b) noexcept { slot().set_type(b ? JSON_TRUE : JSON_FALSE); return true; }
+    bool on_number(double d) noexcept { slot().set_number(d); return true; }
+    bool on_string(string_view str) noexcept {
+        JSON_STAT(m_allocs += !m_insitu && str.size() > sso_capacity());
+        if (m_insitu) slot().borrow_string(str);
+        else slot().set_string(str);
+        return true;
+    }
+    bool on_start_array() noexcept {
+        JsonValue& jv = slot();
+        jv.set_array(JsonValue::Array());
+        m_stack.push_back(&jv);
+        return true;
+    }
+    bool on_end_array(size_t) noexcept { m_stack.pop_back(); return true; }
+    bool on_start_object() noexcept {
+        JsonValue& jv = slot();
+        jv.set_object(JsonValue::Object());
+        m_stack.push_back(&jv);
+        return true;
+    }
+    // a duplicated key reuses its slot, the later value overwrites the former one
+    bool on_key(string_view key) noexcept {
+        JsonValue::Object& obj = m_stack.back()->m_obj;
+        // only read by the counter, the loads are dropped without JSON_STATS
+        [[maybe_unused]] size_t size = obj.size(), capacity = obj.capacity();
+        m_member = m_insitu ? &obj.insert_borrowed(key) : &obj.insert(key);
+        JSON_STAT(m_allocs += obj.size() > size ? (size == capacity) + (!m_insitu && key.size() > sso_capacity()) : 0);
+        return true;
+    }
+    bool on_end_object(size_t) noexcept { m_stack.pop_back(); return true; }
+
+    // heap blocks asked for by the tree so far, only counted with JSON_STATS, see Stats::allocs
+    size_t get_allocs() const noexcept { return m_allocs; }
+
+private:
+    // the slot of the next value, parents never move while their children are being built
+    JsonValue& slot() noexcept {
+        if (m_stack.empty()) return m_root;
+        JsonValue* top = m_stack.back();
+        if (top->m_type == JSON_ARRAY) {
+            JSON_STAT(m_allocs += top->m_arr.size() == top->m_arr.capacity());
+            top->m_arr.emplace_back();
+            return top->m_arr.back();
+        }
+        return *m_member;
+    }
+    // longer strings do not fit into a String itself
+    static size_t sso_capacity() noexcept {
+        static const size_t capacity = JsonValue::String().capacity();
+        return capacity;
+    }
+
+private:
+    JsonValue& m_root;
+    // open arrays/objects from the root down
+    vector<JsonValue*> m_stack;
+    // slot created by the last key
+    JsonValue* m_member;
+    bool m_insitu;
+    size_t m_allocs;
+};
+
+// helpers which do not depend on Handler, see JsonParser.cpp
+const char* parse_hex4(const char* p, unsigned& u) noexcept;
+void encode_utf8(string& str, unsigned u) noexcept;
+// a token has to end at whitespace, an op char or a quote, else bytes behind it were never indexed, e.g. "1x" or "nullnull"
+bool ends_token(char ch) noexcept;
+
+// the json grammar, which drives any Handler with events
+template <class Handler>
+class GenericParser {
 public:
-    Parser();
+    // [json, end) is the whole text, nothing behind end is ever read, so it needs no '\0' terminator
+    GenericParser(Handler& handler, const string& json) noexcept
+        : GenericParser(handler, json.c_str(), json.c_str() + json.size()) {}
+    // the text is not copied, so a temporary would be gone before parse()
+    GenericParser(Handler& handler, string&& json) = delete;
+    GenericParser(Handler& handler, const char* json, const char* end) noexcept
+        : m_handler(handler), m_json(json), m_end(end), m_begin(json), m_cur(0), m_insitu(false), m_depth(0) {}
     // notice that if we don't define dtor here, error "undefined reference" will occur
-    ~Parser() {}
-    // only one way to construct a Parser class, thus copy constructor was set as deleted
-    Parser(JsonValue& jv, const string& json);
-    // only port provided for outside to parse a json
-    int parse();
+    ~GenericParser() {}
+
+    // the whole text must be one value
+    int parse() noexcept;
+    // same result as parse(), but walks a structural index built by find_structurals() instead of every byte
+    int parse_staged() noexcept;
+    // parse one value at the front, the text behind it is not looked at
+    int parse_prefix() noexcept;
+    // same as parse(), but the text must be writable, escaped strings are decoded over their own escapes
+    // so every string_view sent to the handler points into the text and stays valid as long as the text does
+    int parse_insitu() noexcept;
+
+    // counters of the last parse, all zero unless built with JSON_STATS, see JsonStats.h
+    const Stats& get_stats() const noexcept { return m_stats; }
 
 private:
-    Parser(const Parser&) = delete;
-    // all necessary API functions provided by Parser class, notice that some funcitons should not set as noexcept
+    GenericParser(const GenericParser&) = delete;
+    // all necessary API functions provided by GenericParser class
+    // the current byte is ch, false at the end of the text
+    bool at(char ch) const noexcept { return m_json < m_end && *m_json == ch; }
     void parse_whitespace() noexcept;
-    int parse_literal(const string& literal, JSON_TYPE type);
-    int parse_number();
-    const char* parse_hex4(const char* &p, unsigned& u);
-    void parse_encode_utf8(string &str, unsigned u) const noexcept;
-    int parse_string_raw(string& tmp);
-    int parse_string();
-    int parse_array();
-    int parse_object();
-    int parse_value();
+    int parse_literal(const char* literal, JSON_TYPE type) noexcept;
+    int parse_number() noexcept;
+    int parse_string_raw(string_view& str) noexcept;
+    int parse_string() noexcept;
+    int parse_array() noexcept;
+    int parse_object() noexcept;
+    int parse_value() noexcept;
+
+    // stage 2 of parse_staged(), any failure only means "not valid", the exact error is found out afterwards
+    const char* peek_token() const noexcept;
+    // first byte of the next token, '\0' at the end of the text
+    char peek_char() const noexcept;
+    void next_token() noexcept;
+    int parse_indexed_value() noexcept;
+    int parse_indexed_array() noexcept;
+    int parse_indexed_object() noexcept;
 
 private:
-    // store & sync all info in input json
-    JsonValue& m_jv;
-    // same value as input string, using for parsing json
+    Handler& m_handler;
+    // current position in the text
     const char* m_json;
+    // end of the text, nothing at or beyond it is read
+    const char* m_end;
+    // start of the text and its structural index, the last entry is the offset of m_end
+    const char* m_begin;
+    vector<uint32_t> m_index;
+    size_t m_cur;
+    // decoded strings with escapes, plain strings are passed as views into the text
+    string m_buf;
+    // set by parse_insitu(), decoded strings are then copied back into the text
+    bool m_insitu;
+    // only touched through JSON_STAT(), m_depth is the number of open arrays and objects
+    Stats m_stats;
+    size_t m_depth;
 };
 
+// the parser used by JsonValue::parse(), building a tree is just one handler among others
+using Parser = GenericParser<DomHandler>;
+
+// overall process to parse a json
+template <class Handler>
+int GenericParser<Handler>::parse() noexcept {
+    int ret;
+    parse_whitespace();
+    // OMG I wrote ret == parse_value() once here, what a disaster!!!
+    if ((ret = parse_value()) == PARSE_OK) {
+        parse_whitespace();
+        if (m_json != m_end) {
+            ret = PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    JSON_STAT(m_stats.bytes = m_json - m_begin);
+    return ret;
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_prefix() noexcept {
+    parse_whitespace();
+    int ret = parse_value();
+    JSON_STAT(m_stats.bytes = m_json - m_begin);
+    return ret;
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_insitu() noexcept {
+    m_insitu = true;
+    return parse();
+}
+
+// stage 1 finds all tokens at once with SIMD, stage 2 sends the events from the index without looking at whitespace
+template <class Handler>
+int GenericParser<Handler>::parse_staged() noexcept {
+    size_t len = m_end - m_begin;
+    if (len >= UINT32_MAX) return parse();
+#if JSON_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    m_index.reserve(len / 8 + 2);
+    find_structurals(m_begin, m_end, m_index);
+    m_index.push_back((uint32_t)len);
+    JSON_STAT(m_stats.index_seconds = stat_seconds(start));
+    m_cur = 0;
+    int ret = parse_indexed_value();
+    if (ret == PARSE_OK && m_cur + 1 != m_index.size()) {
+        ret = PARSE_ROOT_NOT_SINGULAR;
+    }
+    // invalid input is rare, so stage 2 does not care which error it is, a recursive pass without events finds out
+    if (ret != PARSE_OK && ret != PARSE_ABORTED) {
+        BaseHandler quiet;
+        GenericParser<BaseHandler> check(quiet, m_begin, m_end);
+        ret = check.parse();
+        assert(ret != PARSE_OK);
+        JSON_STAT(len = check.get_stats().bytes);
+    }
+    JSON_STAT(m_stats.bytes = len);
+    return ret;
+}
+
+// skip all unnecessary spaces, most tokens are followed by no or one space, so only longer runs go to the SIMD kernel
+template <class Handler>
+void GenericParser<Handler>::parse_whitespace() noexcept {
+    if (m_json < m_end && (*m_json == ' ' || *m_json == '\t' || *m_json == '\n' || *m_json == '\r')) {
+        ++m_json;
+        if (m_json < m_end && (*m_json == ' ' || *m_json == '\t' || *m_json == '\n' || *m_json == '\r')) {
+            m_json = skip_whitespace(m_json, m_end);
+        }
+    }
+}
+
+// parse null/false/true three different types
+template <class Handler>
+int GenericParser<Handler>::parse_literal(const char* literal, JSON_TYPE type) noexcept {
+    size_t i;
+    assert(*m_json == literal[0]);
+    ++m_json;
+    for (i = 0; literal[i + 1] != '\0'; ++i) {
+        if (m_json + i == m_end || m_json[i] != literal[i + 1]) {
+            return PARSE_INVALID_VALUE;
+        }
+    }
+    m_json += i;
+    JSON_STAT(++m_stats.nodes[type]);
+    bool ok = (type == JSON_NULL) ? m_handler.on_null() : m_handler.on_bool(type == JSON_TRUE);
+    return ok ? PARSE_OK : PARSE_ABORTED;
+}
+
+// parse number according to standard https://github.com/miloyip/json-tutorial/blob/master/tutorial02/images/number.png
+template <class Handler>
+int GenericParser<Handler>::parse_number() noexcept {
+    DecimalNumber num;
+    // grammar check and digit accumulation happen in one pass, the digits are never scanned again on the fast paths
+    const char* p = scan_number(m_json, m_end, num);
+    if (p == NULL) return PARSE_INVALID_VALUE;
+    // own conversion instead of strtod, it is locale independent and much faster
+    double d = decimal_to_double(num);
+    if (d == HUGE_VAL || d == -HUGE_VAL) return PARSE_NUMBER_TOO_BIG;
+    m_json = p;
+    JSON_STAT(++m_stats.nodes[JSON_NUMBER]);
+    JSON_STAT(++m_stats.numbers);
+    JSON_STAT(m_stats.slow_numbers += !is_fast_number(num));
+    return m_handler.on_number(d) ? PARSE_OK : PARSE_ABORTED;
+}
+
+// a string without escapes is passed as a view into the text, otherwise it is decoded into m_buf
+template <class Handler>
+int GenericParser<Handler>::parse_string_raw(string_view& str) noexcept {
+    assert(*m_json == '\"');
+    const char* start = ++m_json;
+    const char* p = scan_string(start, m_end);
+    if (p == m_end) return PARSE_MISS_QUOTATION_MARK;
+    if (*p == '\"') {
+        str = string_view(start, p - start);
+        m_json = p + 1;
+        JSON_STAT(m_stats.string_bytes += str.size());
+        return PARSE_OK;
+    }
+    m_buf.assign(start, p - start);
+    unsigned u1, u2;
+    while (true) {
+        if (p == m_end) return PARSE_MISS_QUOTATION_MARK;
+        char ch = *p++;
+        switch (ch) {
+            case '\"' :
+                m_json = p;
+                if (m_insitu) {
+                    // a decoded string is never longer than its escaped text, so it always fits where it came from
+                    char* dst = const_cast<char*>(start);
+                    memcpy(dst, m_buf.data(), m_buf.size());
+                    str = string_view(dst, m_buf.size());
+                } else {
+                    str = m_buf;
+                }
+                JSON_STAT(m_stats.string_bytes += str.size());
+                return PARSE_OK;
+            case '\\' :
+                if (p == m_end) return PARSE_INVALID_STRING_ESCAPE;
+                JSON_STAT(++m_stats.escapes);
+                switch (*p++) {
+                    case '\"' : m_buf += '\"'; break;
+                    case '\\' : m_buf += '\\'; break;
+                    case '/'  : m_buf += '/';  break;
+                    case 'b'  : m_buf += '\b'; break;
+                    case 'f'  : m_buf += '\f'; break;
+                    case 'n'  : m_buf += '\n'; break;
+                    case 'r'  : m_buf += '\r'; break;
+                    case 't'  : m_buf += '\t'; break;
+                    case 'u'  :
+                        if (m_end - p < 4 || (p = parse_hex4(p, u1)) == NULL) return PARSE_INVALID_UNICODE_HEX;
+                        if (u1 >= 0xD800 && u1 <= 0xDBFF) {
+                            if (p == m_end || *p++ != '\\') return PARSE_INVALID_UNICODE_SURROGATE;
+                            if (p == m_end || *p++ != 'u') return PARSE_INVALID_UNICODE_SURROGATE;
+                            if (m_end - p < 4 || (p = parse_hex4(p, u2)) == NULL) return PARSE_INVALID_UNICODE_HEX;
+                            if (u2 < 0xDC00 || u2 > 0XDFFF) return PARSE_INVALID_UNICODE_SURROGATE;
+                            u1 = (((u1 - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+                        }
+                        encode_utf8(m_buf, u1);
+                        break;
+                    default : return PARSE_INVALID_STRING_ESCAPE;
+                }
+                break;
+            default :
+                // scan_string only stops at control chars besides '\"' and '\\', a raw '\0' is one of them
+                return PARSE_INVALID_STRING_CHAR;
+        }
+        // bulk append the next run of plain chars
+        const char* q = scan_string(p, m_end);
+        m_buf.append(p, q - p);
+        p = q;
+    }
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_string() noexcept {
+    string_view str;
+    int ret = parse_string_raw(str);
+    if (ret != PARSE_OK) return ret;
+    JSON_STAT(++m_stats.nodes[JSON_STRING]);
+    return m_handler.on_string(str) ? PARSE_OK : PARSE_ABORTED;
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_array() noexcept {
+    int ret;
+    size_t count = 0;
+    assert(*m_json == '[');
+    ++m_json;
+    parse_whitespace();
+    JSON_STAT(++m_stats.nodes[JSON_ARRAY]);
+    JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+    if (!m_handler.on_start_array()) return PARSE_ABORTED;
+    if (at(']')) {
+        ++m_json;
+        JSON_STAT(--m_depth);
+        return m_handler.on_end_array(0) ? PARSE_OK : PARSE_ABORTED;
+    }
+    while (true) {
+        if ((ret = parse_value()) != PARSE_OK) {
+            return ret;
+        }
+        ++count;
+        parse_whitespace();
+        if (at(',')) {
+            ++m_json;
+            parse_whitespace();
+        } else if (at(']')) {
+            ++m_json;
+            JSON_STAT(--m_depth);
+            return m_handler.on_end_array(count) ? PARSE_OK : PARSE_ABORTED;
+        } else {
+            return PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+        }
+    }
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_object() noexcept {
+    int ret;
+    size_t count = 0;
+    string_view key;
+    assert(*m_json == '{');
+    ++m_json;
+    parse_whitespace();
+    JSON_STAT(++m_stats.nodes[JSON_OBJECT]);
+    JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+    if (!m_handler.on_start_object()) return PARSE_ABORTED;
+    if (at('}')) {
+        ++m_json;
+        JSON_STAT(--m_depth);
+        return m_handler.on_end_object(0) ? PARSE_OK : PARSE_ABORTED;
+    }
+    while (true) {
+        if (!at('\"')) {
+            return PARSE_MISS_KEY;
+        }
+        if ((ret = parse_string_raw(key)) != PARSE_OK) {
+            return ret;
+        }
+        parse_whitespace();
+        if (!at(':')) {
+            return PARSE_MISS_COLON;
+        }
+        ++m_json;
+        parse_whitespace();
+        JSON_STAT(++m_stats.keys);
+        if (!m_handler.on_key(key)) return PARSE_ABORTED;
+        if ((ret = parse_value()) != PARSE_OK) {
+            return ret;
+        }
+        ++count;
+        parse_whitespace();
+        if (at(',')) {
+            ++m_json;
+            parse_whitespace();
+        } else if (at('}')) {
+            ++m_json;
+            JSON_STAT(--m_depth);
+            return m_handler.on_end_object(count) ? PARSE_OK : PARSE_ABORTED;
+        } else {
+            // forgot to return here once, TEST_ERROR error happened
+            return PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+        }
+    }
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_value() noexcept {
+    if (m_json == m_end) return PARSE_EXPECT_VALUE;
+    // a raw '\0' is no value either, it goes to parse_number() like any other invalid byte
+    switch (*m_json) {
+        case 't' : return parse_literal("true", JSON_TRUE);
+        case 'f' : return parse_literal("false", JSON_FALSE);
+        case 'n' : return parse_literal("null", JSON_NULL);
+        case '\"' : return parse_string();
+        case '[' : return parse_array();
+        case '{' : return parse_object();
+        default : return parse_number();
+    }
+}
+
+// the last entry (m_end) is never passed, so a truncated text keeps peeking at the end there
+template <class Handler>
+inline const char* GenericParser<Handler>::peek_token() const noexcept {
+    return m_begin + m_index[m_cur];
+}
+
+template <class Handler>
+inline char GenericParser<Handler>::peek_char() const noexcept {
+    const char* p = peek_token();
+    return p < m_end ? *p : '\0';
+}
+
+template <class Handler>
+inline void GenericParser<Handler>::next_token() noexcept {
+    if (m_cur + 1 < m_index.size()) ++m_cur;
+}
+
+// strings, numbers and literals reuse the parse_xxx functions of the recursive parser
+template <class Handler>
+int GenericParser<Handler>::parse_indexed_value() noexcept {
+    int ret;
+    m_json = peek_token();
+    next_token();
+    if (m_json == m_end) return PARSE_EXPECT_VALUE;
+    switch (*m_json) {
+        case '{' : return parse_indexed_object();
+        case '[' : return parse_indexed_array();
+        case '\"' : ret = parse_string(); break;
+        case 't' : ret = parse_literal("true", JSON_TRUE); break;
+        case 'f' : ret = parse_literal("false", JSON_FALSE); break;
+        case 'n' : ret = parse_literal("null", JSON_NULL); break;
+        default : ret = parse_number(); break;
+    }
+    if (ret != PARSE_OK) return ret;
+    // stage 1 and parse_string() must agree where a string ends
+    if ((m_json != m_end && !ends_token(*m_json)) || peek_token() < m_json) return PARSE_INVALID_VALUE;
+    return PARSE_OK;
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_indexed_array() noexcept {
+    int ret;
+    size_t count = 0;
+    JSON_STAT(++m_stats.nodes[JSON_ARRAY]);
+    JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+    if (!m_handler.on_start_array()) return PARSE_ABORTED;
+    if (peek_char() == ']') {
+        next_token();
+        JSON_STAT(--m_depth);
+        return m_handler.on_end_array(0) ? PARSE_OK : PARSE_ABORTED;
+    }
+    while (true) {
+        if ((ret = parse_indexed_value()) != PARSE_OK) {
+            return ret;
+        }
+        ++count;
+        char ch = peek_char();
+        next_token();
+        if (ch == ']') {
+            JSON_STAT(--m_depth);
+            return m_handler.on_end_array(count) ? PARSE_OK : PARSE_ABORTED;
+        }
+        if (ch != ',') return PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+}
+
+template <class Handler>
+int GenericParser<Handler>::parse_indexed_object() noexcept {
+    int ret;
+    size_t count = 0;
+    string_view key;
+    JSON_STAT(++m_stats.nodes[JSON_OBJECT]);
+    JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+    if (!m_handler.on_start_object()) return PARSE_ABORTED;
+    if (peek_char() == '}') {
+        next_token();
+        JSON_STAT(--m_depth);
+        return m_handler.on_end_object(0) ? PARSE_OK : PARSE_ABORTED;
+    }
+    while (true) {
+        m_json = peek_token();
+        next_token();
+        if (m_json == m_end || *m_json != '\"') return PARSE_MISS_KEY;
+        if ((ret = parse_string_raw(key)) != PARSE_OK) return ret;
+        if (peek_token() < m_json) return PARSE_MISS_QUOTATION_MARK;
+        if (peek_char() != ':') return PARSE_MISS_COLON;
+        next_token();
+        JSON_STAT(++m_stats.keys);
+        if (!m_handler.on_key(key)) return PARSE_ABORTED;
+        if ((ret = parse_indexed_value()) != PARSE_OK) {
+            return ret;
+        }
+        ++count;
+        char ch = peek_char();
+        next_token();
+        if (ch == '}') {
+            JSON_STAT(--m_depth);
+            return m_handler.on_end_object(count) ? PARSE_OK : PARSE_ABORTED;
+        }
+        if (ch != ',') return PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
 };
 
-#endif
\ No newline at end of file
+#endif
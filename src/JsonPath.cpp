@@ -0,0 +1,201 @@
+#include "JsonPath.h"
+
+namespace myJson {
+
+// chars of a name behind '.', anything else needs the bracket form
+static bool is_name_char(char ch) noexcept {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+           ch == '_' || ch == '-' || ch == '$' || (unsigned char)ch >= 0x80;
+}
+
+// an unsigned integer at i, false if there are no digits or it does not fit
+static bool parse_uint(string_view expr, size_t& i, size_t& n) noexcept {
+    size_t begin = i;
+    n = 0;
+    for (; i < expr.size() && expr[i] >= '0' && expr[i] <= '9'; ++i) {
+        if (i - begin == 18) return false;
+        n = n * 10 + (expr[i] - '0');
+    }
+    return i > begin;
+}
+
+bool JsonPath::parse(string_view expr) noexcept {
+    m_steps.clear();
+    m_valid = !expr.empty() && expr[0] == '$' && parse_steps(expr);
+    if (!m_valid) m_steps.clear();
+    return m_valid;
+}
+
+bool JsonPath::parse_steps(string_view expr) noexcept {
+    size_t i = 1;
+    while (i < expr.size()) {
+        Step step{STEP_NAME, false, string(), 0, 0, 1};
+        if (expr[i] == '[') {
+            if (!parse_bracket(expr, i, step)) return false;
+        } else if (expr[i] == '.') {
+            ++i;
+            if (i < expr.size() && expr[i] == '.') {
+                step.descendant = true;
+                ++i;
+            }
+            if (i < expr.size() && expr[i] == '*') {
+                step.type = STEP_WILDCARD;
+                ++i;
+            } else if (i < expr.size() && expr[i] == '[' && step.descendant) {
+                // "..[0]" and "..['a b']", while ".[0]" is no valid step
+                if (!parse_bracket(expr, i, step)) return false;
+            } else {
+                size_t begin = i;
+                while (i < expr.size() && is_name_char(expr[i])) ++i;
+                if (i == begin) return false;
+                step.name.assign(expr.data() + begin, i - begin);
+            }
+        } else {
+            return false;
+        }
+        if (m_steps.size() == MAX_STEPS) return false;
+        m_steps.push_back(std::move(step));
+    }
+    return true;
+}
+
+// one of [*], ['name'], ["name"], [n] or [start:end:step] at i, the descendant flag of step is kept
+bool JsonPath::parse_bracket(string_view expr, size_t& i, Step& step) noexcept {
+    ++i;
+    if (i < expr.size() && expr[i] == '*') {
+        step.type = STEP_WILDCARD;
+        ++i;
+    } else if (i < expr.size() && (expr[i] == '\'' || expr[i] == '\"')) {
+        // a quoted name, '\\' takes the next char as it is, so it can escape the quote and itself
+        char quote = expr[i++];
+        step.type = STEP_NAME;
+        for (; i < expr.size() && expr[i] != quote; ++i) {
+            if (expr[i] == '\\' && ++i == expr.size()) return false;
+            step.name += expr[i];
+        }
+        if (i == expr.size()) return false;
+        ++i;
+    } else {
+        step.type = STEP_SLICE;
+        bool has_start = parse_uint(expr, i, step.start);
+        if (i < expr.size() && expr[i] == ':') {
+            // [start:end:step], each part may be left out, [:] is every element
+            if (!has_start) step.start = 0;
+            ++i;
+            if (!parse_uint(expr, i, step.end)) step.end = SIZE_MAX;
+            if (i < expr.size() && expr[i] == ':') {
+                ++i;
+                if (!parse_uint(expr, i, step.step)) step.step = 1;
+                if (step.step == 0) return false;
+            }
+        } else {
+            if (!has_start) return false;
+            step.end = step.start + 1;
+        }
+    }
+    if (i == expr.size() || expr[i] != ']') return false;
+    ++i;
+    return true;
+}
+
+uint64_t JsonPath::next_states(uint64_t states, string_view key) const noexcept {
+    uint64_t next = 0;
+    // the final state has no step, nothing below a selected value is selected by being below it
+    states &= final_state() - 1;
+    for (; states != 0; states &= states - 1) {
+        size_t i = __builtin_ctzll(states);
+        const Step& step = m_steps[i];
+        if (step.descendant) next |= (uint64_t)1 << i;
+        if (step.type == STEP_WILDCARD || (step.type == STEP_NAME && step.name == key)) next |= (uint64_t)2 << i;
+    }
+    return next;
+}
+
+uint64_t JsonPath::next_states(uint64_t states, size_t index) const noexcept {
+    uint64_t next = 0;
+    states &= final_state() - 1;
+    for (; states != 0; states &= states - 1) {
+        size_t i = __builtin_ctzll(states);
+        const Step& step = m_steps[i];
+        if (step.descendant) next |= (uint64_t)1 << i;
+        if (step.type == STEP_WILDCARD ||
+            (step.type == STEP_SLICE && index >= step.start && index < step.end && (index - step.start) % step.step == 0)) {
+            next |= (uint64_t)2 << i;
+        }
+    }
+    return next;
+}
+
+int JsonPath::select(string_view json, vector<JsonValue>& out, PARSE_ENGINE engine) const noexcept {
+    out.clear();
+    // an invalid path selects nothing, but the text is still checked
+    PathMatcher matcher(*this, out);
+    GenericParser<PathMatcher> p(matcher, json.data(), json.data() + json.size());
+    int ret = (engine == ENGINE_STAGED) ? p.parse_staged() : p.parse();
+    if (ret != PARSE_OK) out.clear();
+    return ret;
+}
+
+PathMatcher::PathMatcher(const JsonPath& path, vector<JsonValue>& out) noexcept
+    : m_path(path), m_out(out), m_skip(0), m_key_states(0), m_active(0) {
+    m_frames.reserve(16);
+}
+
+uint64_t PathMatcher::enter() noexcept {
+    if (m_skip > 0) return 0;
+    if (m_frames.empty()) return m_path.root_states();
+    Frame& top = m_frames.back();
+    return top.is_array ? m_path.next_states(top.states, top.index++) : m_key_states;
+}
+
+void PathMatcher::begin(uint64_t states) noexcept {
+    if ((states & m_path.final_state()) == 0) return;
+    if (m_active == m_builders.size()) m_builders.push_back(make_unique<Builder>());
+    Builder& builder = *m_builders[m_active++];
+    // the slot is taken now, so an outer match stays in front of the matches inside it
+    builder.slot = m_out.size();
+    builder.depth = 0;
+    m_out.emplace_back();
+}
+
+void PathMatcher::finish() noexcept {
+    Builder& builder = *m_builders[--m_active];
+    m_out[builder.slot] = std::move(builder.value);
+}
+
+bool PathMatcher::on_start(bool is_array) noexcept {
+    uint64_t states = enter();
+    begin(states);
+    for (size_t i = 0; i < m_active; ++i) {
+        Builder& builder = *m_builders[i];
+        if (is_array) builder.dom.on_start_array();
+        else builder.dom.on_start_object();
+        ++builder.depth;
+    }
+    // no state with a step left, the whole container is skipped, only its depth is counted
+    if ((states & (m_path.final_state() - 1)) == 0) ++m_skip;
+    else m_frames.push_back(Frame{states, is_array, 0});
+    return true;
+}
+
+bool PathMatcher::on_key(string_view key) noexcept {
+    if (m_skip == 0) m_key_states = m_path.next_states(m_frames.back().states, key);
+    for (size_t i = 0; i < m_active; ++i) m_builders[i]->dom.on_key(key);
+    return true;
+}
+
+bool PathMatcher::on_end(bool is_array, size_t count) noexcept {
+    if (m_skip > 0) --m_skip;
+    else m_frames.pop_back();
+    for (size_t i = 0; i < m_active; ++i) {
+        Builder& builder = *m_builders[i];
+        if (is_array) builder.dom.on_end_array(count);
+        else builder.dom.on_end_object(count);
+        --builder.depth;
+    }
+    // only the innermost match can end here
+    if (m_active > 0 && m_builders[m_active - 1]->depth == 0) finish();
+    return true;
+}
+
+};
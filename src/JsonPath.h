@@ -0,0 +1,147 @@
+#ifndef JSON_PATH_H
+#define JSON_PATH_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>       // unique_ptr
+#include <cstdint>      // uint64_t
+#include "JsonEnum.h"
+#include "JsonValue.h"
+#include "JsonParser.h"
+
+using namespace std;
+
+namespace myJson {
+
+// a JSONPath expression, compiled once into a list of steps which PathMatcher runs over the events of a parser
+// so the values it selects are found while the text is parsed, without a tree of the whole document
+// the subset is: $ root, .name and ['name'] child, .* and [*] wildcard, [n] index, [start:end:step] slice
+// and .. recursive descent in front of any of them, e.g. "$.items[*].price", "$..id", "$.a[1:10:2]", "$..['key']"
+// indexes and slice bounds can not be negative, an event parser does not know the length of an array in advance
+class JsonPath {
+public:
+    // "$", the whole document
+    JsonPath() noexcept : m_valid(true) {}
+    explicit JsonPath(string_view expr) noexcept { parse(expr); }
+
+    // false when expr is not in the subset above, or has more than MAX_STEPS steps
+    bool parse(string_view expr) noexcept;
+    bool is_valid() const noexcept { return m_valid; }
+    size_t size() const noexcept { return m_steps.size(); }
+
+    // out is set to the selected values in document order (an outer match comes before the matches inside it)
+    // return the PARSE_TYPE of the whole text, out is empty on an error or for an invalid path
+    int select(string_view json, vector<JsonValue>& out, PARSE_ENGINE engine = ENGINE_RECURSIVE) const noexcept;
+
+    // the states below are one bit per step, see next_states()
+    static constexpr size_t MAX_STEPS = 63;
+
+private:
+    enum STEP_TYPE {
+        STEP_NAME = 0,
+        STEP_WILDCARD,
+        // [n] is the slice [n:n+1:1]
+        STEP_SLICE
+    };
+
+    struct Step {
+        STEP_TYPE type;
+        // behind "..", the step may match at any depth below
+        bool descendant;
+        string name;
+        size_t start;
+        size_t end;
+        size_t step;
+    };
+
+    // the automaton is a set of states, bit i means the first i steps matched the path from the root to this value
+    // so bit size() means the value is selected, and 0 means nothing below can ever be selected
+    uint64_t root_states() const noexcept { return m_valid ? 1 : 0; }
+    uint64_t final_state() const noexcept { return (uint64_t)1 << m_steps.size(); }
+    // states of the member key, or of the element index, of a value in states
+    uint64_t next_states(uint64_t states, string_view key) const noexcept;
+    uint64_t next_states(uint64_t states, size_t index) const noexcept;
+
+    // the steps of expr behind '$'
+    bool parse_steps(string_view expr) noexcept;
+    // one bracket at i, i is moved past it
+    bool parse_bracket(string_view expr, size_t& i, Step& step) noexcept;
+
+private:
+    vector<Step> m_steps;
+    bool m_valid;
+
+    friend class PathMatcher;
+};
+
+// a handler for GenericParser or GenericStreamParser which builds the values selected by a JsonPath and nothing else
+// subtrees which can not contain a match only move a depth counter, every match is built by its own DomHandler
+class PathMatcher {
+public:
+    // each match is appended to out, in document order
+    PathMatcher(const JsonPath& path, vector<JsonValue>& out) noexcept;
+
+    bool on_null() noexcept { return on_scalar([](DomHandler& dom) { return dom.on_null(); }); }
+    bool on_bool(bool b) noexcept { return on_scalar([b](DomHandler& dom) { return dom.on_bool(b); }); }
+    bool on_number(double d) noexcept { return on_scalar([d](DomHandler& dom) { return dom.on_number(d); }); }
+    bool on_string(string_view str) noexcept { return on_scalar([str](DomHandler& dom) { return dom.on_string(str); }); }
+    bool on_start_array() noexcept { return on_start(true); }
+    bool on_end_array(size_t count) noexcept { return on_end(true, count); }
+    bool on_start_object() noexcept { return on_start(false); }
+    bool on_key(string_view key) noexcept;
+    bool on_end_object(size_t count) noexcept { return on_end(false, count); }
+
+private:
+    PathMatcher(const PathMatcher&) = delete;
+
+    // one open container which may still contain a match
+    struct Frame {
+        uint64_t states;
+        bool is_array;
+        // index of the next element
+        size_t index;
+    };
+    // one match being built, it goes to m_out[slot] once its value ends
+    struct Builder {
+        Builder() noexcept : dom(value), slot(0), depth(0) {}
+        JsonValue value;
+        DomHandler dom;
+        size_t slot;
+        // open containers inside value
+        size_t depth;
+    };
+
+    // states of the value which starts now
+    uint64_t enter() noexcept;
+    // value starts with states, begin a Builder if it is selected
+    void begin(uint64_t states) noexcept;
+    // hand the finished top Builder over to m_out
+    void finish() noexcept;
+    bool on_start(bool is_array) noexcept;
+    bool on_end(bool is_array, size_t count) noexcept;
+
+    template <class Event>
+    bool on_scalar(Event event) noexcept {
+        begin(enter());
+        for (size_t i = 0; i < m_active; ++i) event(m_builders[i]->dom);
+        // a scalar only ends a match which it started itself, the outer ones are inside a container
+        if (m_active > 0 && m_builders[m_active - 1]->depth == 0) finish();
+        return true;
+    }
+
+private:
+    const JsonPath& m_path;
+    vector<JsonValue>& m_out;
+    vector<Frame> m_frames;
+    // open containers below the last frame where nothing can match
+    size_t m_skip;
+    // states of the member whose key came last
+    uint64_t m_key_states;
+    // matches nest, the ones in progress are m_builders[0, m_active), the rest are kept for reuse
+    vector<unique_ptr<Builder>> m_builders;
+    size_t m_active;
+};
+
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "JsonPointer.h"
+#include "JsonObject.h"
+
+namespace myJson {
+
+// array index of a token, npos unless it is "0" or digits without a leading zero, as RFC 6901 asks
+static size_t parse_index(string_view token) noexcept {
+    if (token.empty() || token.size() > 19 || (token[0] == '0' && token.size() > 1)) return JsonObject::npos;
+    size_t index = 0;
+    for (char ch : token) {
+        if (ch < '0' || ch > '9') return JsonObject::npos;
+        index = index * 10 + (ch - '0');
+    }
+    return index;
+}
+
+bool JsonPointer::parse(string_view path) noexcept {
+    m_keys.clear();
+    m_tokens.clear();
+    m_valid = path.empty() || path[0] == '/';
+    if (path.empty() || !m_valid) return m_valid;
+    m_keys.reserve(path.size());
+    size_t i = 1;
+    while (true) {
+        Token token;
+        token.offset = (uint32_t)m_keys.size();
+        // unescape once here, "~1" is '/' and "~0" is '~', in this order, so "~01" is "~1"
+        for (; i < path.size() && path[i] != '/'; ++i) {
+            if (path[i] != '~') {
+                m_keys += path[i];
+            } else if (i + 1 < path.size() && (path[i + 1] == '0' || path[i + 1] == '1')) {
+                m_keys += path[++i] == '0' ? '~' : '/';
+            } else {
+                m_keys.clear();
+                m_tokens.clear();
+                return m_valid = false;
+            }
+        }
+        token.length = (uint32_t)(m_keys.size() - token.offset);
+        string_view key(m_keys.data() + token.offset, token.length);
+        token.hash = JsonObject::hash_key(key);
+        token.index = parse_index(key);
+        m_tokens.push_back(token);
+        if (i == path.size()) break;
+        // skip the '/' in front of the next token
+        ++i;
+    }
+    return true;
+}
+
+string_view JsonPointer::get_token(size_t index) const noexcept {
+    const Token& token = m_tokens[index];
+    return string_view(m_keys.data() + token.offset, token.length);
+}
+
+// one step down, a key of an object or an index of an array, any other value has no children
+JsonRef JsonPointer::resolve_token(JsonRef jv, const Token& token, string_view key) noexcept {
+    const JsonValue* value = jv.get_value();
+    if (value == nullptr) return JsonRef();
+    if (value->get_type() == JSON_OBJECT) {
+        const JsonObject& obj = value->get_object();
+        size_t pos = obj.find(key, token.hash);
+        return pos != JsonObject::npos ? JsonRef(obj[pos].second) : JsonRef();
+    }
+    // npos is never below the size
+    if (value->get_type() != JSON_ARRAY || token.index >= value->get_array_size()) return JsonRef();
+    return JsonRef(value->get_array_element(token.index));
+}
+
+JsonRef JsonPointer::resolve(JsonRef root) const noexcept {
+    if (!m_valid) return JsonRef();
+    for (size_t i = 0; i < m_tokens.size() && root.exists(); ++i) {
+        root = resolve_token(root, m_tokens[i], get_token(i));
+    }
+    return root;
+}
+
+JsonPointerSet::JsonPointerSet() noexcept : m_nodes(1), m_count(0) {}
+
+size_t JsonPointerSet::add(const JsonPointer& pointer) noexcept {
+    uint32_t slot = (uint32_t)m_count++;
+    // the slot of an invalid pointer is never written by resolve_node(), resolve() fills all slots with missing first
+    if (!pointer.is_valid()) return slot;
+    uint32_t cur = 0;
+    for (size_t i = 0; i < pointer.size(); ++i) {
+        string_view key = pointer.get_token(i);
+        uint32_t next = 0;
+        for (uint32_t child : m_nodes[cur].children) {
+            const JsonPointer::Token& token = m_nodes[child].token;
+            if (string_view(m_keys.data() + token.offset, token.length) == key) {
+                next = child;
+                break;
+            }
+        }
+        if (next == 0) {
+            Node node;
+            node.token = pointer.m_tokens[i];
+            node.token.offset = (uint32_t)m_keys.size();
+            m_keys.append(key.data(), key.size());
+            next = (uint32_t)m_nodes.size();
+            m_nodes.push_back(std::move(node));
+            m_nodes[cur].children.push_back(next);
+        }
+        cur = next;
+    }
+    m_nodes[cur].slots.push_back(slot);
+    return slot;
+}
+
+void JsonPointerSet::resolve(JsonRef root, JsonRef* out) const noexcept {
+    for (size_t i = 0; i < m_count; ++i) out[i] = JsonRef();
+    resolve_node(m_nodes[0], root, out);
+}
+
+void JsonPointerSet::resolve(JsonRef root, vector<JsonRef>& out) const noexcept {
+    out.resize(m_count);
+    resolve(root, out.data());
+}
+
+// depth first, a missing value leaves every slot below it missing, so the subtree of the trie is not walked
+void JsonPointerSet::resolve_node(const Node& node, JsonRef jv, JsonRef* out) const noexcept {
+    if (!jv.exists()) return;
+    for (uint32_t slot : node.slots) out[slot] = jv;
+    for (uint32_t child : node.children) {
+        const JsonPointer::Token& token = m_nodes[child].token;
+        string_view key(m_keys.data() + token.offset, token.length);
+        resolve_node(m_nodes[child], JsonPointer::resolve_token(jv, token, key), out);
+    }
+}
+
+};
@@ -0,0 +1,92 @@
+#ifndef JSON_POINTER_H
+#define JSON_POINTER_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>      // uint32_t
+#include "JsonValue.h"
+#include "JsonRef.h"
+
+using namespace std;
+
+namespace myJson {
+
+// a JSON Pointer (RFC 6901) such as "/items/0/price", parsed once into unescaped tokens which carry the hash of the key
+// and the array index they stand for, so resolving it is one lookup per level without allocating anything
+class JsonPointer {
+public:
+    // "" points at the whole document
+    JsonPointer() noexcept : m_valid(true) {}
+    explicit JsonPointer(string_view path) noexcept { parse(path); }
+
+    // false when path neither is "" nor starts with '/', or '~' is not followed by '0' or '1'
+    // the URI fragment form "#/..." is not accepted, decode it first
+    bool parse(string_view path) noexcept;
+    bool is_valid() const noexcept { return m_valid; }
+
+    size_t size() const noexcept { return m_tokens.size(); }
+    // the unescaped token, e.g. "a/b" for "/a~1b"
+    string_view get_token(size_t index) const noexcept;
+
+    // the value the pointer points at, missing if any token does not exist or the pointer is invalid
+    // "-" (the element behind the last one) never exists
+    JsonRef resolve(JsonRef root) const noexcept;
+
+private:
+    // where one unescaped token lives in m_keys
+    struct Token {
+        uint32_t offset;
+        uint32_t length;
+        size_t hash;
+        // npos unless the token is an array index, i.e. "0" or digits without a leading zero
+        size_t index;
+    };
+
+    static JsonRef resolve_token(JsonRef jv, const Token& token, string_view key) noexcept;
+
+private:
+    // all unescaped tokens back to back, Token keeps offsets so a copied pointer stays valid
+    string m_keys;
+    vector<Token> m_tokens;
+    bool m_valid;
+
+    friend class JsonPointerSet;
+};
+
+// many pointers resolved against one document in a single walk, tokens shared by several pointers are looked up once
+// e.g. "/user/name" and "/user/id" find "user" only once
+class JsonPointerSet {
+public:
+    JsonPointerSet() noexcept;
+
+    // return the slot of pointer in the results of resolve(), an invalid pointer gets one which always stays missing
+    size_t add(const JsonPointer& pointer) noexcept;
+    size_t add(string_view path) noexcept { return add(JsonPointer(path)); }
+    size_t size() const noexcept { return m_count; }
+
+    // out[i] is what the i-th added pointer points at, out must have room for size() refs, nothing is allocated
+    void resolve(JsonRef root, JsonRef* out) const noexcept;
+    // the same, out is resized to size()
+    void resolve(JsonRef root, vector<JsonRef>& out) const noexcept;
+
+private:
+    // a trie of tokens, node 0 is the root, i.e. the pointer ""
+    struct Node {
+        JsonPointer::Token token;
+        vector<uint32_t> children;
+        // slots of the pointers which end here
+        vector<uint32_t> slots;
+    };
+
+    void resolve_node(const Node& node, JsonRef jv, JsonRef* out) const noexcept;
+
+private:
+    vector<Node> m_nodes;
+    // the keys of all nodes, like JsonPointer::m_keys
+    string m_keys;
+    size_t m_count;
+};
+
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "JsonRef.h"
+
+namespace myJson {
+
+JSON_TYPE JsonRef::get_type() const noexcept {
+    return m_jv != nullptr ? m_jv->get_type() : JSON_NULL;
+}
+
+double JsonRef::get_number(double def) const noexcept {
+    return get_type() == JSON_NUMBER ? m_jv->get_number() : def;
+}
+
+bool JsonRef::get_bool(bool def) const noexcept {
+    switch (get_type()) {
+        case JSON_TRUE : return true;
+        case JSON_FALSE : return false;
+        default : return def;
+    }
+}
+
+string_view JsonRef::get_string(string_view def) const noexcept {
+    return get_type() == JSON_STRING ? m_jv->get_string() : def;
+}
+
+size_t JsonRef::get_array_size() const noexcept {
+    return get_type() == JSON_ARRAY ? m_jv->get_array_size() : 0;
+}
+
+size_t JsonRef::get_object_size() const noexcept {
+    return get_type() == JSON_OBJECT ? m_jv->get_object_size() : 0;
+}
+
+JsonRef JsonRef::get_array_element(size_t index) const noexcept {
+    if (index >= get_array_size()) return JsonRef();
+    return JsonRef(m_jv->get_array_element(index));
+}
+
+bool JsonRef::find_object_key(string_view key) const noexcept {
+    return get_type() == JSON_OBJECT && m_jv->find_object_key(key);
+}
+
+JsonRef JsonRef::get_object_value(string_view key) const noexcept {
+    if (get_type() != JSON_OBJECT) return JsonRef();
+    // one lookup, JsonValue::get_object_value() would search again after find_object_key()
+    const JsonObject& obj = m_jv->get_object();
+    size_t index = obj.find(key);
+    return index != JsonObject::npos ? JsonRef(obj[index].second) : JsonRef();
+}
+
+JsonRef::ArrayRange JsonRef::get_array() const noexcept {
+    size_t size = get_array_size();
+    if (size == 0) return ArrayRange();
+    // the elements as they are stored, get_array_element() would resolve links, ArrayIterator does that
+    const JsonValue* first = m_jv->m_arr.data();
+    return ArrayRange(ArrayIterator(first), ArrayIterator(first + size));
+}
+
+JsonRef::ObjectRange JsonRef::get_object() const noexcept {
+    if (get_type() != JSON_OBJECT) return ObjectRange();
+    const JsonObject& obj = m_jv->get_object();
+    return ObjectRange(ObjectIterator(obj.begin()), ObjectIterator(obj.end()));
+}
+
+bool operator==(const JsonRef& lhs, const JsonRef& rhs) noexcept {
+    if (!lhs.exists() || !rhs.exists()) return lhs.exists() == rhs.exists();
+    return *lhs.get_value() == *rhs.get_value();
+}
+
+bool operator!=(const JsonRef& lhs, const JsonRef& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+};
@@ -0,0 +1,129 @@
+#ifndef JSON_REF_H
+#define JSON_REF_H
+#include <string_view>
+#include <iterator>     // forward_iterator_tag
+#include <cstddef>      // ptrdiff_t
+#include "JsonEnum.h"
+#include "JsonValue.h"
+
+using namespace std;
+
+namespace myJson {
+
+// JsonRef is a pointer to a value inside a tree, it never copies and never allocates
+// a missing member or element gives a missing ref, which reads like JSON_NULL, so lookups chain without checks:
+//     double price = ref["items"][0]["price"].get_number();
+// notice that the tree must outlive every ref into it, and any change of a container may move its children
+class JsonRef {
+public:
+    class ArrayIterator;
+    class ObjectIterator;
+    struct Member;
+    template <class Iterator> class Range;
+    using ArrayRange = Range<ArrayIterator>;
+    using ObjectRange = Range<ObjectIterator>;
+
+    JsonRef() noexcept : m_jv(nullptr) {}
+    // not explicit, so a JsonValue can be passed wherever a ref is expected, a link refers to its target
+    JsonRef(const JsonValue& jv) noexcept : m_jv(&jv.resolve()) {}
+
+    // false only for a missing member or element, a JSON_NULL value exists
+    bool exists() const noexcept { return m_jv != nullptr; }
+    // JSON_NULL when missing
+    JSON_TYPE get_type() const noexcept;
+    // the value behind the ref, nullptr when missing
+    const JsonValue* get_value() const noexcept { return m_jv; }
+
+    // typed accessors, def when the value is missing or of another type
+    double get_number(double def = 0) const noexcept;
+    bool get_bool(bool def = false) const noexcept;
+    string_view get_string(string_view def = string_view()) const noexcept;
+
+    // 0 for other types
+    size_t get_array_size() const noexcept;
+    size_t get_object_size() const noexcept;
+    // missing when index is out of range or this is no array
+    JsonRef get_array_element(size_t index) const noexcept;
+    bool find_object_key(string_view key) const noexcept;
+    // missing when key does not exist or this is no object
+    JsonRef get_object_value(string_view key) const noexcept;
+    JsonRef operator[](size_t index) const noexcept { return get_array_element(index); }
+    JsonRef operator[](string_view key) const noexcept { return get_object_value(key); }
+
+    // range-for over elements or members, empty for other types
+    ArrayRange get_array() const noexcept;
+    ObjectRange get_object() const noexcept;
+
+private:
+    const JsonValue* m_jv;
+};
+
+// what ObjectIterator yields, for (auto [key, value] : ref.get_object()) works
+struct JsonRef::Member {
+    string_view key;
+    JsonRef value;
+};
+
+class JsonRef::ArrayIterator {
+public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = JsonRef;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = JsonRef;
+
+    ArrayIterator() noexcept : m_pos(nullptr) {}
+    explicit ArrayIterator(const JsonValue* pos) noexcept : m_pos(pos) {}
+    JsonRef operator*() const noexcept { return JsonRef(*m_pos); }
+    ArrayIterator& operator++() noexcept { ++m_pos; return *this; }
+    ArrayIterator operator++(int) noexcept { ArrayIterator tmp(*this); ++m_pos; return tmp; }
+    bool operator==(const ArrayIterator& rhs) const noexcept { return m_pos == rhs.m_pos; }
+    bool operator!=(const ArrayIterator& rhs) const noexcept { return m_pos != rhs.m_pos; }
+
+private:
+    // elements of an array are contiguous
+    const JsonValue* m_pos;
+};
+
+class JsonRef::ObjectIterator {
+public:
+    using iterator_category = forward_iterator_tag;
+    using value_type = Member;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = Member;
+
+    ObjectIterator() noexcept {}
+    explicit ObjectIterator(JsonObject::const_iterator pos) noexcept : m_pos(pos) {}
+    Member operator*() const noexcept { return Member{m_pos->first.view(), JsonRef(m_pos->second)}; }
+    ObjectIterator& operator++() noexcept { ++m_pos; return *this; }
+    ObjectIterator operator++(int) noexcept { ObjectIterator tmp(*this); ++m_pos; return tmp; }
+    bool operator==(const ObjectIterator& rhs) const noexcept { return m_pos == rhs.m_pos; }
+    bool operator!=(const ObjectIterator& rhs) const noexcept { return m_pos != rhs.m_pos; }
+
+private:
+    // members in insertion order, see JsonObject.h
+    JsonObject::const_iterator m_pos;
+};
+
+template <class Iterator>
+class JsonRef::Range {
+public:
+    Range() noexcept {}
+    Range(Iterator begin, Iterator end) noexcept : m_begin(begin), m_end(end) {}
+    Iterator begin() const noexcept { return m_begin; }
+    Iterator end() const noexcept { return m_end; }
+    bool empty() const noexcept { return m_begin == m_end; }
+
+private:
+    Iterator m_begin;
+    Iterator m_end;
+};
+
+// same as operator== of JsonValue, a missing ref only equals another missing ref
+bool operator==(const JsonRef& lhs, const JsonRef& rhs) noexcept;
+bool operator!=(const JsonRef& lhs, const JsonRef& rhs) noexcept;
+
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "JsonSimd.h"
+#include <atomic>
+#include <cstring>  // memcpy, memset
+
+#if defined(__x86_64__) || defined(__i386__)
+#define JSON_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace myJson {
+
+// scalar kernels, used for short tails and on cpus without SSE2
+static inline bool is_whitespace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+static inline bool is_string_special(char ch) {
+    return ch == '\"' || ch == '\\' || (unsigned char)ch < 0x20;
+}
+
+static const char* skip_whitespace_scalar(const char* p, const char* end) noexcept {
+    while (p < end && is_whitespace(*p)) ++p;
+    return p;
+}
+
+static const char* scan_string_scalar(const char* p, const char* end) noexcept {
+    while (p < end && !is_string_special(*p)) ++p;
+    return p;
+}
+
+// stage 1 works on 64 byte blocks, every kernel only classifies bytes into four bit masks, index_block() does the rest
+struct BlockMasks {
+    uint64_t whitespace;
+    uint64_t op;
+    uint64_t quote;
+    uint64_t backslash;
+};
+
+// carried from one block to the next
+struct StructuralState {
+    // 1 when the first byte of the next block is escaped by a backslash
+    uint64_t escaped;
+    // all ones when the next block starts inside a string
+    uint64_t in_string;
+    // 1 when the last byte of the block belongs to a token (number, literal or garbage)
+    uint64_t token;
+};
+
+static inline bool is_op(char ch) {
+    return ch == '{' || ch == '}' || ch == '[' || ch == ']' || ch == ':' || ch == ',';
+}
+
+static inline void index_block(BlockMasks m, StructuralState& st, uint32_t base, vector<uint32_t>& index) {
+    // a backslash escapes the next byte unless it is escaped itself, backslashes are rare so walk them one by one
+    uint64_t escaped = st.escaped;
+    st.escaped = 0;
+    for (uint64_t bs = m.backslash; bs != 0; bs &= bs - 1) {
+        int i = __builtin_ctzll(bs);
+        if ((escaped >> i) & 1) continue;
+        if (i == 63) st.escaped = 1;
+        else escaped |= 1ULL << (i + 1);
+    }
+    uint64_t quote = m.quote & ~escaped;
+    // prefix xor, bit i is set when an odd number of quotes is at or before it, i.e. an opening quote or string content
+    uint64_t in_string = quote;
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    in_string ^= in_string << 16;
+    in_string ^= in_string << 32;
+    in_string ^= st.in_string;
+    st.in_string = (uint64_t)((int64_t)in_string >> 63);
+    // closing quotes are the only quotes outside in_string
+    uint64_t token = ~(m.whitespace | m.op | quote | in_string);
+    uint64_t token_start = token & ~((token << 1) | st.token);
+    st.token = token >> 63;
+    uint64_t structurals = (m.op & ~in_string) | (quote & in_string) | token_start;
+
+    size_t n = index.size();
+    index.resize(n + __builtin_popcountll(structurals));
+    uint32_t* out = index.data() + n;
+    for (; structurals != 0; structurals &= structurals - 1) {
+        *out++ = base + __builtin_ctzll(structurals);
+    }
+}
+
+static BlockMasks classify_scalar(const char* p) noexcept {
+    BlockMasks m = {0, 0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+        uint64_t bit = 1ULL << i;
+        if (is_whitespace(p[i])) m.whitespace |= bit;
+        else if (is_op(p[i])) m.op |= bit;
+        else if (p[i] == '\"') m.quote |= bit;
+        else if (p[i] == '\\') m.backslash |= bit;
+    }
+    return m;
+}
+
+// the last partial block is padded with spaces, which are never indexed
+template <BlockMasks (*classify)(const char*) noexcept>
+static inline void find_structurals_with(const char* p, const char* end, vector<uint32_t>& index) {
+    StructuralState st = {0, 0, 0};
+    const char* begin = p;
+    for (; p + 64 <= end; p += 64) {
+        index_block(classify(p), st, (uint32_t)(p - begin), index);
+    }
+    if (p < end) {
+        char buf[64];
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf, p, end - p);
+        index_block(classify(buf), st, (uint32_t)(p - begin), index);
+    }
+}
+
+static void find_structurals_scalar(const char* p, const char* end, vector<uint32_t>& index) {
+    find_structurals_with<classify_scalar>(p, end, index);
+}
+
+#ifdef JSON_SIMD_X86
+// every 16/32 byte block is turned into a bit mask of interesting bytes, the lowest set bit is the answer
+// notice that there is no unsigned byte compare, x < 0x20 is checked as min(x, 0x1F) == x instead
+__attribute__((target("sse2")))
+static const char* skip_whitespace_sse2(const char* p, const char* end) noexcept {
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+    for (; p + 16 <= end; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, lf), _mm_cmpeq_epi8(x, cr)));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(ws) & 0xFFFF;
+        if (mask != 0) return p + __builtin_ctz(mask);
+    }
+    return skip_whitespace_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* scan_string_sse2(const char* p, const char* end) noexcept {
+    const __m128i quote = _mm_set1_epi8('\"'), backslash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    for (; p + 16 <= end; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(x, ctrl), x));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+        if (mask != 0) return p + __builtin_ctz(mask);
+    }
+    return scan_string_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skip_whitespace_avx2(const char* p, const char* end) noexcept {
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    for (; p + 32 <= end; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, space), _mm256_cmpeq_epi8(x, tab)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, lf), _mm256_cmpeq_epi8(x, cr)));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(ws);
+        if (mask != 0) return p + __builtin_ctz(mask);
+    }
+    return skip_whitespace_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* scan_string_avx2(const char* p, const char* end) noexcept {
+    const __m256i quote = _mm256_set1_epi8('\"'), backslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl = _mm256_set1_epi8(0x1F);
+    for (; p + 32 <= end; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, backslash)),
+                                          _mm256_cmpeq_epi8(_mm256_min_epu8(x, ctrl), x));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(special);
+        if (mask != 0) return p + __builtin_ctz(mask);
+    }
+    return scan_string_sse2(p, end);
+}
+
+// '[' and '{' (also ']' and '}') only differ in bit 0x20, so or-ing it in saves two compares
+__attribute__((target("sse2")))
+static BlockMasks classify_sse2(const char* p) noexcept {
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+    const __m128i open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}'), bit20 = _mm_set1_epi8(0x20);
+    const __m128i colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('\"'), backslash = _mm_set1_epi8('\\');
+    BlockMasks m = {0, 0, 0, 0};
+    for (int i = 0; i < 64; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lower = _mm_or_si128(x, bit20);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, space), _mm_cmpeq_epi8(x, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, lf), _mm_cmpeq_epi8(x, cr)));
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, open), _mm_cmpeq_epi8(lower, close)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, colon), _mm_cmpeq_epi8(x, comma)));
+        m.whitespace |= (uint64_t)(unsigned)_mm_movemask_epi8(ws) << i;
+        m.op |= (uint64_t)(unsigned)_mm_movemask_epi8(op) << i;
+        m.quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, quote)) << i;
+        m.backslash |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, backslash)) << i;
+    }
+    return m;
+}
+
+__attribute__((target("avx2")))
+static BlockMasks classify_avx2(const char* p) noexcept {
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    const __m256i open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}'), bit20 = _mm256_set1_epi8(0x20);
+    const __m256i colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('\"'), backslash = _mm256_set1_epi8('\\');
+    BlockMasks m = {0, 0, 0, 0};
+    for (int i = 0; i < 64; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i lower = _mm256_or_si256(x, bit20);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, space), _mm256_cmpeq_epi8(x, tab)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, lf), _mm256_cmpeq_epi8(x, cr)));
+        __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, open), _mm256_cmpeq_epi8(lower, close)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, colon), _mm256_cmpeq_epi8(x, comma)));
+        m.whitespace |= (uint64_t)(unsigned)_mm256_movemask_epi8(ws) << i;
+        m.op |= (uint64_t)(unsigned)_mm256_movemask_epi8(op) << i;
+        m.quote |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, quote)) << i;
+        m.backslash |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, backslash)) << i;
+    }
+    return m;
+}
+
+// the whole loop is compiled once per instruction set, so that classify can be inlined into it
+__attribute__((target("sse2")))
+static void find_structurals_sse2(const char* p, const char* end, vector<uint32_t>& index) {
+    find_structurals_with<classify_sse2>(p, end, index);
+}
+
+__attribute__((target("avx2")))
+static void find_structurals_avx2(const char* p, const char* end, vector<uint32_t>& index) {
+    find_structurals_with<classify_avx2>(p, end, index);
+}
+#endif
+
+// kernels of one level, switched as a whole by set_simd_level()
+struct Kernels {
+    SIMD_LEVEL level;
+    const char* (*skip_whitespace)(const char*, const char*) noexcept;
+    const char* (*scan_string)(const char*, const char*) noexcept;
+    void (*find_structurals)(const char*, const char*, vector<uint32_t>&);
+};
+
+static const Kernels scalar_kernels = {SIMD_SCALAR, skip_whitespace_scalar, scan_string_scalar, find_structurals_scalar};
+#ifdef JSON_SIMD_X86
+static const Kernels sse2_kernels = {SIMD_SSE2, skip_whitespace_sse2, scan_string_sse2, find_structurals_sse2};
+static const Kernels avx2_kernels = {SIMD_AVX2, skip_whitespace_avx2, scan_string_avx2, find_structurals_avx2};
+#endif
+
+static SIMD_LEVEL supported_level() noexcept {
+#ifdef JSON_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+static const Kernels* kernels_of(SIMD_LEVEL level) noexcept {
+    SIMD_LEVEL best = supported_level();
+    if (level > best) level = best;
+    switch (level) {
+#ifdef JSON_SIMD_X86
+        case SIMD_AVX2 : return &avx2_kernels;
+        case SIMD_SSE2 : return &sse2_kernels;
+#endif
+        default : return &scalar_kernels;
+    }
+}
+
+// null until the first call, then points to the kernels of the best supported level
+static atomic<const Kernels*> current_kernels(nullptr);
+
+static inline const Kernels* kernels() noexcept {
+    const Kernels* k = current_kernels.load(memory_order_relaxed);
+    if (k == nullptr) {
+        k = kernels_of(SIMD_AVX2);
+        current_kernels.store(k, memory_order_relaxed);
+    }
+    return k;
+}
+
+SIMD_LEVEL get_simd_level() noexcept {
+    return kernels()->level;
+}
+
+void set_simd_level(SIMD_LEVEL level) noexcept {
+    current_kernels.store(kernels_of(level), memory_order_relaxed);
+}
+
+const char* skip_whitespace(const char* p, const char* end) noexcept {
+    return kernels()->skip_whitespace(p, end);
+}
+
+const char* scan_string(const char* p, const char* end) noexcept {
+    return kernels()->scan_string(p, end);
+}
+
+void find_structurals(const char* p, const char* end, vector<uint32_t>& index) {
+    kernels()->find_structurals(p, end, index);
+}
+
+};
@@ -0,0 +1,34 @@
+#ifndef JSON_SIMD_H
+#define JSON_SIMD_H
+#include <vector>
+#include <cstdint>  // uint32_t
+
+using namespace std;
+
+namespace myJson {
+
+// instruction sets the scanning kernels can use, the best one supported by current cpu is picked at runtime
+enum SIMD_LEVEL {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+SIMD_LEVEL get_simd_level() noexcept;
+// force a lower level (mainly for tests and benchmarks), a level the cpu does not support falls back to the best supported one
+void set_simd_level(SIMD_LEVEL level) noexcept;
+
+// both kernels only read inside [p, end) and return end when nothing was found
+// return the first byte which is not ' ', '\t', '\n' or '\r'
+const char* skip_whitespace(const char* p, const char* end) noexcept;
+// return the first byte which ends an unescaped run of string chars, i.e. '\"', '\\' or a control char < 0x20
+const char* scan_string(const char* p, const char* end) noexcept;
+
+// stage 1 of ENGINE_STAGED, append the offset (from p) of every structural char {}[]:, outside strings, every opening quote
+// and the first byte of every other token, so any byte outside strings is either whitespace, indexed, or inside a token
+// the text must be shorter than 4GB, offsets are 32 bits
+void find_structurals(const char* p, const char* end, vector<uint32_t>& index);
+
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "JsonSink.h"
+#include <algorithm>    // max, min
+#include <cstring>      // memcpy
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <cerrno>
+#define JSON_HAS_UNISTD 1
+#else
+#include <io.h>
+#include <climits>  // INT_MAX
+#endif
+
+namespace myJson {
+
+void Sink::write_slow(const char* data, size_t len) noexcept {
+    while (len > 0) {
+        if (m_pos == m_end) grow(min(len, MIN_ROOM));
+        size_t n = min(len, (size_t)(m_end - m_pos));
+        memcpy(m_pos, data, n);
+        m_pos += n;
+        data += n;
+        len -= n;
+    }
+}
+
+StringSink::StringSink(string& str) noexcept : m_str(str) {
+    m_pos = m_chunk;
+    m_end = m_chunk + CHUNK;
+}
+
+bool StringSink::flush() noexcept {
+    // append() grows geometrically like push_back does, and never touches bytes it does not copy
+    m_str.append(m_chunk, m_pos - m_chunk);
+    m_pos = m_chunk;
+    return true;
+}
+
+void StringSink::grow(size_t) noexcept {
+    // an emptied chunk always has CHUNK >= MIN_ROOM
+    flush();
+}
+
+BufferedSink::BufferedSink(size_t capacity) noexcept : m_buf(max(capacity, MIN_ROOM)), m_ok(true) {
+    m_pos = m_buf.data();
+    m_end = m_pos + m_buf.size();
+}
+
+bool BufferedSink::flush() noexcept {
+    if (m_pos != m_buf.data()) {
+        if (m_ok) m_ok = write_chunk(m_buf.data(), m_pos - m_buf.data());
+        m_pos = m_buf.data();
+    }
+    return m_ok;
+}
+
+void BufferedSink::grow(size_t) noexcept {
+    // an emptied buffer always has MIN_ROOM, bytes after a failed write are dropped
+    flush();
+}
+
+bool FdSink::write_chunk(const char* data, size_t len) noexcept {
+    while (len > 0) {
+#ifdef JSON_HAS_UNISTD
+        ssize_t n = ::write(m_fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+#else
+        int n = _write(m_fd, data, (unsigned)min(len, (size_t)INT_MAX));
+#endif
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool FileSink::write_chunk(const char* data, size_t len) noexcept {
+    return fwrite(data, 1, len, m_file) == len;
+}
+
+bool OstreamSink::write_chunk(const char* data, size_t len) noexcept {
+    m_os.write(data, len);
+    return !m_os.fail();
+}
+
+bool CallbackSink::write_chunk(const char* data, size_t len) noexcept {
+    return m_callback(data, len);
+}
+
+};
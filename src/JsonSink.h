@@ -0,0 +1,168 @@
+#ifndef JSON_SINK_H
+#define JSON_SINK_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>       // FILE
+#include <ostream>
+#include <functional>   // function
+#include <cstring>      // memcpy
+
+using namespace std;
+
+namespace myJson {
+
+// where Generator writes to, bytes go into a buffer [m_pos, m_end) first, only a full buffer costs a virtual call
+class Sink {
+public:
+    // reserve() never asks for more than this, every buffer has at least that much room once it is emptied
+    static constexpr size_t MIN_ROOM = 64;
+
+    Sink() noexcept : m_pos(nullptr), m_end(nullptr) {}
+    virtual ~Sink() noexcept {}
+
+    void put(char ch) noexcept {
+        if (m_pos == m_end) grow(1);
+        *m_pos++ = ch;
+    }
+    void write(const char* data, size_t len) noexcept {
+        if (len <= (size_t)(m_end - m_pos)) {
+            memcpy(m_pos, data, len);
+            m_pos += len;
+        } else {
+            write_slow(data, len);
+        }
+    }
+    void write(string_view str) noexcept { write(str.data(), str.size()); }
+    // contiguous room for n <= MIN_ROOM bytes, fill some of them and pass the end of what was written to commit()
+    char* reserve(size_t n) noexcept {
+        if ((size_t)(m_end - m_pos) < n) grow(n);
+        return m_pos;
+    }
+    void commit(char* end) noexcept { m_pos = end; }
+    // hand every buffered byte to the target, return false once any write has failed
+    // notice that a BufferedSink does not flush in its dtor, write_chunk() is gone by then, stringify() flushes when it is done
+    virtual bool flush() noexcept = 0;
+
+protected:
+    // make room for at least n more bytes behind m_pos
+    virtual void grow(size_t n) noexcept = 0;
+    // write() when the buffer is too small, it is filled and emptied as often as needed
+    void write_slow(const char* data, size_t len) noexcept;
+
+protected:
+    char* m_pos;
+    char* m_end;
+};
+
+// appends to a string through a small chunk inside the sink, which is never initialized
+// the string only grows by append(), so nothing is zero-filled first, and a reserve() in front makes it one allocation
+class StringSink : public Sink {
+public:
+    static constexpr size_t CHUNK = 4096;
+
+    explicit StringSink(string& str) noexcept;
+    ~StringSink() noexcept override { flush(); }
+    // append what is in the chunk
+    bool flush() noexcept override;
+
+private:
+    void grow(size_t n) noexcept override;
+
+private:
+    string& m_str;
+    char m_chunk[CHUNK];
+};
+
+// writes straight into memory which is known to be large enough, e.g. a string resized to get_stringify_size()
+// the same calls as Sink without any check or virtual call, so it is no Sink but a type of its own, see GenericGenerator
+class ExactWriter {
+public:
+    explicit ExactWriter(char* pos) noexcept : m_pos(pos) {}
+
+    void put(char ch) noexcept { *m_pos++ = ch; }
+    void write(const char* data, size_t len) noexcept {
+        memcpy(m_pos, data, len);
+        m_pos += len;
+    }
+    void write(string_view str) noexcept { write(str.data(), str.size()); }
+    // reserve(n) may be filled with up to n bytes even when fewer are kept, so the memory needs that slack at its end
+    char* reserve(size_t) noexcept { return m_pos; }
+    void commit(char* end) noexcept { m_pos = end; }
+    // end of what was written
+    char* get_pos() const noexcept { return m_pos; }
+
+private:
+    char* m_pos;
+};
+
+// collects bytes in a fixed chunk and writes it out whenever it is full, peak memory is the chunk whatever the output size
+class BufferedSink : public Sink {
+public:
+    explicit BufferedSink(size_t capacity = 64 * 1024) noexcept;
+    bool flush() noexcept override;
+
+protected:
+    // write all of [data, data + len), false on any error, after that nothing is written any more
+    virtual bool write_chunk(const char* data, size_t len) noexcept = 0;
+
+private:
+    void grow(size_t n) noexcept override;
+
+private:
+    vector<char> m_buf;
+    bool m_ok;
+};
+
+// a file descriptor, e.g. a socket or a pipe, partial writes and EINTR are retried, the fd is not closed
+class FdSink : public BufferedSink {
+public:
+    explicit FdSink(int fd, size_t capacity = 64 * 1024) noexcept : BufferedSink(capacity), m_fd(fd) {}
+
+protected:
+    bool write_chunk(const char* data, size_t len) noexcept override;
+
+private:
+    int m_fd;
+};
+
+// a stdio FILE, it is neither flushed nor closed
+class FileSink : public BufferedSink {
+public:
+    explicit FileSink(FILE* file, size_t capacity = 64 * 1024) noexcept : BufferedSink(capacity), m_file(file) {}
+
+protected:
+    bool write_chunk(const char* data, size_t len) noexcept override;
+
+private:
+    FILE* m_file;
+};
+
+class OstreamSink : public BufferedSink {
+public:
+    explicit OstreamSink(ostream& os, size_t capacity = 64 * 1024) noexcept : BufferedSink(capacity), m_os(os) {}
+
+protected:
+    bool write_chunk(const char* data, size_t len) noexcept override;
+
+private:
+    ostream& m_os;
+};
+
+// every full chunk is passed to callback, which returns false to report an error
+class CallbackSink : public BufferedSink {
+public:
+    using Callback = function<bool(const char*, size_t)>;
+    explicit CallbackSink(Callback callback, size_t capacity = 64 * 1024) noexcept
+        : BufferedSink(capacity), m_callback(std::move(callback)) {}
+
+protected:
+    bool write_chunk(const char* data, size_t len) noexcept override;
+
+private:
+    Callback m_callback;
+};
+
+};
+
+#endif
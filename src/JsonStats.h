@@ -0,0 +1,60 @@
+#ifndef JSON_STATS_H
+#define JSON_STATS_H
+#include <cstddef>  // size_t
+#include <chrono>
+#include "JsonEnum.h"
+
+using namespace std;
+
+// counters are only compiled in with JSON_STATS=1 (cmake -DJSON_STATS=ON), otherwise JSON_STAT() expands to nothing
+// and a Stats passed to parse()/stringify() always comes back zeroed, so the hot paths stay exactly as they are
+#ifndef JSON_STATS
+#define JSON_STATS 0
+#endif
+
+#if JSON_STATS
+#define JSON_STAT(expr) ((void)(expr))
+#else
+#define JSON_STAT(expr) ((void)0)
+#endif
+
+namespace myJson {
+
+// what one parse() or stringify() call went through, GenericParser and DomHandler or Generator fill it in
+struct Stats {
+    // text read by parse() (up to the error if it failed), or written by stringify()
+    size_t bytes = 0;
+    // values per JSON_TYPE, keys are not values, they are counted by keys
+    size_t nodes[JSON_OBJECT + 1] = {};
+    size_t keys = 0;
+    // nesting of arrays and objects, 0 for a scalar root
+    size_t max_depth = 0;
+    // chars of all strings and keys as they are in the tree, i.e. without quotes and escapes
+    size_t string_bytes = 0;
+    // escape sequences decoded or written, a surrogate pair counts once
+    size_t escapes = 0;
+    // numbers converted from or into text, and how many of those parse() could not do on the fast path
+    size_t numbers = 0;
+    size_t slow_numbers = 0;
+    // parse() only, growths of arrays and member vectors and strings or keys too long for SSO, i.e. heap blocks the tree
+    // asked for, the hash index of big objects and the scratch buffers of the parser are not counted
+    size_t allocs = 0;
+    // wall time of the whole call, and of stage 1 of ENGINE_STAGED within it
+    double seconds = 0;
+    double index_seconds = 0;
+
+    size_t total_nodes() const noexcept {
+        size_t n = 0;
+        for (size_t count : nodes) n += count;
+        return n;
+    }
+};
+
+// only used inside JSON_STAT()
+inline double stat_seconds(chrono::steady_clock::time_point start) noexcept {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+};
+
+#endif
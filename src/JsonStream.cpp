@@ -0,0 +1,22 @@
+#include "JsonStream.h"
+
+namespace myJson {
+
+int StreamParser::feed(const char* data, size_t len) noexcept {
+    int ret = m_parser.feed(data, len);
+    // no more events come after an error, so the half-built tree can go at once
+    if (ret != PARSE_OK) {
+        m_jv.set_type(JSON_NULL);
+    }
+    return ret;
+}
+
+int StreamParser::finish() noexcept {
+    int ret = m_parser.finish();
+    if (ret != PARSE_OK) {
+        m_jv.set_type(JSON_NULL);
+    }
+    return ret;
+}
+
+};
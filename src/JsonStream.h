@@ -0,0 +1,453 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cmath>    // HUGE_VAL
+#include "JsonEnum.h"
+#include "JsonValue.h"
+#include "JsonParser.h"
+#include "JsonSimd.h"
+#include "JsonNumber.h"
+
+using namespace std;
+
+namespace myJson {
+
+// push parser for a text which arrives in chunks, e.g. from a socket, so it never has to be buffered whole
+// open containers, half-read strings, numbers and escapes are kept as state between two feed() calls
+// the events and the PARSE_TYPE are the same as the ones of GenericParser::parse() on the whole text
+template <class Handler>
+class GenericStreamParser {
+public:
+    explicit GenericStreamParser(Handler& handler) noexcept
+        : m_handler(handler), m_state(ST_VALUE), m_ret(PARSE_OK), m_ended(false) {}
+    ~GenericStreamParser() {}
+
+    // chunks may be split anywhere, even inside a number or an escape, and are not referenced after the call
+    // return PARSE_OK while the text so far can still become valid, else the first error, which is kept from then on
+    int feed(const char* data, size_t len) noexcept;
+    // the text has ended, return the result of the whole text
+    int finish() noexcept;
+
+private:
+    GenericStreamParser(const GenericStreamParser&) = delete;
+
+    // where the next byte belongs to
+    enum STATE {
+        // whitespace or a value
+        ST_VALUE = 0,
+        // behind '[', whitespace, ']' or a value
+        ST_ARRAY_FIRST,
+        // behind '{', whitespace, '}' or a key
+        ST_OBJECT_FIRST,
+        // behind ',' in an object, whitespace or a key
+        ST_KEY,
+        // behind a key, whitespace or ':'
+        ST_COLON,
+        // behind a value, whitespace, ',' or the closing bracket, at the root only whitespace
+        ST_NEXT,
+        // inside null/true/false
+        ST_LITERAL,
+        // inside a number, which is collected into m_buf
+        ST_NUMBER,
+        // inside a string, decoded chars are collected into m_buf
+        ST_STRING,
+        // behind '\\'
+        ST_ESCAPE,
+        // inside \uXXXX, and inside the \uXXXX of a low surrogate
+        ST_HEX,
+        ST_HEX_LOW,
+        // behind a high surrogate, '\\' and 'u' of the low one must follow
+        ST_SURROGATE,
+        ST_SURROGATE_U
+    };
+
+    // grammar of a number as in scan_number(), NUM_END means the byte is not part of the number any more
+    enum NUMBER_STATE {
+        NUM_START = 0, NUM_SIGN, NUM_ZERO, NUM_INT, NUM_DOT, NUM_FRAC, NUM_E, NUM_E_SIGN, NUM_EXP,
+        NUM_END, NUM_INVALID
+    };
+
+    struct Frame {
+        bool is_array;
+        size_t count;
+    };
+
+    static bool is_space(char ch) noexcept { return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; }
+    static NUMBER_STATE next_number_state(NUMBER_STATE state, char ch) noexcept;
+
+    // every function below consumes bytes from p on and returns where it stopped, errors are kept in m_ret
+    const char* fail(int ret, const char* p) noexcept { m_ret = ret; return p; }
+    const char* event(bool ok, const char* p) noexcept { if (!ok) m_ret = PARSE_ABORTED; return p; }
+    void end_value() noexcept;
+
+    const char* parse_token(const char* p, const char* end) noexcept;
+    const char* parse_value(const char* p, const char* end) noexcept;
+    const char* end_container(const char* p) noexcept;
+    const char* start_literal(const char* literal, const char* p) noexcept;
+    const char* parse_literal(const char* p, const char* end) noexcept;
+    const char* start_number(const char* p, const char* end) noexcept;
+    const char* parse_number(const char* p, const char* end) noexcept;
+    const char* end_number(const DecimalNumber& num, const char* p) noexcept;
+    const char* start_string(const char* p, const char* end) noexcept;
+    const char* parse_string(const char* p, const char* end) noexcept;
+    const char* end_string(string_view str, const char* p) noexcept;
+    // the error parse() would give when the text ends in the current state
+    int end_of_text() noexcept;
+
+private:
+    Handler& m_handler;
+    STATE m_state;
+    int m_ret;
+    bool m_ended;
+    // open arrays/objects from the root down
+    vector<Frame> m_stack;
+    // the current literal and how many of its chars were matched
+    const char* m_literal;
+    size_t m_matched;
+    NUMBER_STATE m_num_state;
+    // the current number or decoded string, only used when it crosses a chunk boundary or has escapes
+    string m_buf;
+    // the last key, on_key() is sent when its ':' arrives, which may be in a later chunk
+    string m_key;
+    bool m_in_key;
+    // \uXXXX being read, and the high surrogate in front of it
+    unsigned m_hex;
+    unsigned m_hex_count;
+    unsigned m_high;
+};
+
+// builds a JsonValue from chunks, the value is only complete once finish() returned PARSE_OK
+// on any error it is reset to null, as JsonValue::parse() does
+class StreamParser {
+public:
+    explicit StreamParser(JsonValue& jv) noexcept : m_jv(jv), m_handler(jv), m_parser(m_handler) {}
+
+    int feed(const char* data, size_t len) noexcept;
+    int finish() noexcept;
+
+private:
+    StreamParser(const StreamParser&) = delete;
+
+private:
+    JsonValue& m_jv;
+    DomHandler m_handler;
+    GenericStreamParser<DomHandler> m_parser;
+};
+
+template <class Handler>
+int GenericStreamParser<Handler>::feed(const char* data, size_t len) noexcept {
+    if (m_ret != PARSE_OK || m_ended) return m_ret;
+    const char* end = data + len;
+    const char* p = data;
+    while (p < end && m_ret == PARSE_OK) {
+        switch (m_state) {
+            case ST_LITERAL : p = parse_literal(p, end); break;
+            case ST_NUMBER : p = parse_number(p, end); break;
+            case ST_STRING : case ST_ESCAPE : case ST_HEX : case ST_HEX_LOW : case ST_SURROGATE : case ST_SURROGATE_U :
+                p = parse_string(p, end);
+                break;
+            default :
+                // most tokens are followed by no or one space, so only longer runs go to the SIMD kernel
+                if (is_space(*p)) {
+                    if (++p < end && is_space(*p)) p = skip_whitespace(p, end);
+                } else {
+                    p = parse_token(p, end);
+                }
+        }
+    }
+    return m_ret;
+}
+
+template <class Handler>
+int GenericStreamParser<Handler>::finish() noexcept {
+    if (!m_ended) {
+        m_ended = true;
+        if (m_ret == PARSE_OK) m_ret = end_of_text();
+    }
+    return m_ret;
+}
+
+template <class Handler>
+int GenericStreamParser<Handler>::end_of_text() noexcept {
+    switch (m_state) {
+        case ST_VALUE : case ST_ARRAY_FIRST : return PARSE_EXPECT_VALUE;
+        case ST_OBJECT_FIRST : case ST_KEY : return PARSE_MISS_KEY;
+        case ST_COLON : return PARSE_MISS_COLON;
+        case ST_LITERAL : return PARSE_INVALID_VALUE;
+        case ST_NUMBER :
+            // a number at the very end is complete only now
+            if (next_number_state(m_num_state, '\0') == NUM_INVALID) return PARSE_INVALID_VALUE;
+            parse_number(NULL, NULL);
+            if (m_ret != PARSE_OK) return m_ret;
+            return end_of_text();
+        case ST_NEXT :
+            if (m_stack.empty()) return PARSE_OK;
+            return m_stack.back().is_array ? PARSE_MISS_COMMA_OR_SQUARE_BRACKET : PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+        case ST_STRING : return PARSE_MISS_QUOTATION_MARK;
+        case ST_ESCAPE : return PARSE_INVALID_STRING_ESCAPE;
+        case ST_HEX : case ST_HEX_LOW : return PARSE_INVALID_UNICODE_HEX;
+        default : return PARSE_INVALID_UNICODE_SURROGATE;
+    }
+}
+
+template <class Handler>
+void GenericStreamParser<Handler>::end_value() noexcept {
+    if (!m_stack.empty()) ++m_stack.back().count;
+    m_state = ST_NEXT;
+}
+
+// p is at the first byte of a token which is not whitespace
+template <class Handler>
+const char* GenericStreamParser<Handler>::parse_token(const char* p, const char* end) noexcept {
+    switch (m_state) {
+        case ST_ARRAY_FIRST :
+            if (*p == ']') return end_container(p + 1);
+            return parse_value(p, end);
+        case ST_OBJECT_FIRST :
+            if (*p == '}') return end_container(p + 1);
+            return start_string(p, end);
+        case ST_KEY :
+            return start_string(p, end);
+        case ST_COLON :
+            if (*p != ':') return fail(PARSE_MISS_COLON, p);
+            m_state = ST_VALUE;
+            return event(m_handler.on_key(m_key), p + 1);
+        case ST_NEXT :
+            if (m_stack.empty()) return fail(PARSE_ROOT_NOT_SINGULAR, p);
+            if (*p == ',') {
+                m_state = m_stack.back().is_array ? ST_VALUE : ST_KEY;
+                return p + 1;
+            }
+            if (m_stack.back().is_array) {
+                if (*p == ']') return end_container(p + 1);
+                return fail(PARSE_MISS_COMMA_OR_SQUARE_BRACKET, p);
+            }
+            if (*p == '}') return end_container(p + 1);
+            return fail(PARSE_MISS_COMMA_OR_CURLY_BRACKET, p);
+        default :
+            return parse_value(p, end);
+    }
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::parse_value(const char* p, const char* end) noexcept {
+    switch (*p) {
+        case 't' : return start_literal("true", p);
+        case 'f' : return start_literal("false", p);
+        case 'n' : return start_literal("null", p);
+        case '\"' : return start_string(p, end);
+        case '[' :
+            m_stack.push_back(Frame{true, 0});
+            m_state = ST_ARRAY_FIRST;
+            return event(m_handler.on_start_array(), p + 1);
+        case '{' :
+            m_stack.push_back(Frame{false, 0});
+            m_state = ST_OBJECT_FIRST;
+            return event(m_handler.on_start_object(), p + 1);
+        default : return start_number(p, end);
+    }
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::end_container(const char* p) noexcept {
+    Frame top = m_stack.back();
+    m_stack.pop_back();
+    bool ok = top.is_array ? m_handler.on_end_array(top.count) : m_handler.on_end_object(top.count);
+    end_value();
+    return event(ok, p);
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::start_literal(const char* literal, const char* p) noexcept {
+    m_literal = literal;
+    m_matched = 1;
+    m_state = ST_LITERAL;
+    return p + 1;
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::parse_literal(const char* p, const char* end) noexcept {
+    for (; p < end && m_literal[m_matched] != '\0'; ++p, ++m_matched) {
+        if (*p != m_literal[m_matched]) return fail(PARSE_INVALID_VALUE, p);
+    }
+    if (m_literal[m_matched] != '\0') return p;
+    bool ok = (m_literal[0] == 'n') ? m_handler.on_null() : m_handler.on_bool(m_literal[0] == 't');
+    end_value();
+    return event(ok, p);
+}
+
+template <class Handler>
+typename GenericStreamParser<Handler>::NUMBER_STATE
+GenericStreamParser<Handler>::next_number_state(NUMBER_STATE state, char ch) noexcept {
+    bool digit = ch >= '0' && ch <= '9';
+    bool exp = ch == 'e' || ch == 'E';
+    switch (state) {
+        case NUM_START :
+            if (ch == '-') return NUM_SIGN;
+            // fall through
+        case NUM_SIGN :
+            return ch == '0' ? NUM_ZERO : digit ? NUM_INT : NUM_INVALID;
+        case NUM_ZERO :
+            return ch == '.' ? NUM_DOT : exp ? NUM_E : NUM_END;
+        case NUM_INT :
+            return digit ? NUM_INT : ch == '.' ? NUM_DOT : exp ? NUM_E : NUM_END;
+        case NUM_DOT :
+            return digit ? NUM_FRAC : NUM_INVALID;
+        case NUM_FRAC :
+            return digit ? NUM_FRAC : exp ? NUM_E : NUM_END;
+        case NUM_E :
+            return (ch == '+' || ch == '-') ? NUM_E_SIGN : digit ? NUM_EXP : NUM_INVALID;
+        case NUM_E_SIGN :
+            return digit ? NUM_EXP : NUM_INVALID;
+        case NUM_EXP :
+            return digit ? NUM_EXP : NUM_END;
+        default :
+            return NUM_INVALID;
+    }
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::start_number(const char* p, const char* end) noexcept {
+    DecimalNumber num;
+    const char* q = scan_number(p, end, num);
+    // the byte behind the number is inside this chunk too, so it is complete and can be converted in place
+    if (q != NULL && q < end) return end_number(num, q);
+    m_buf.clear();
+    m_num_state = NUM_START;
+    m_state = ST_NUMBER;
+    return parse_number(p, end);
+}
+
+// p == end == NULL when the text ends behind the number
+template <class Handler>
+const char* GenericStreamParser<Handler>::parse_number(const char* p, const char* end) noexcept {
+    const char* start = p;
+    while (p < end) {
+        NUMBER_STATE next = next_number_state(m_num_state, *p);
+        if (next == NUM_INVALID) return fail(PARSE_INVALID_VALUE, p);
+        if (next == NUM_END) break;
+        m_num_state = next;
+        ++p;
+    }
+    if (p != start) m_buf.append(start, p - start);
+    // the number may go on in the next chunk
+    if (p == end && end != NULL) return p;
+    DecimalNumber num;
+    scan_number(m_buf.data(), m_buf.data() + m_buf.size(), num);
+    return end_number(num, p);
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::end_number(const DecimalNumber& num, const char* p) noexcept {
+    double d = decimal_to_double(num);
+    if (d == HUGE_VAL || d == -HUGE_VAL) return fail(PARSE_NUMBER_TOO_BIG, p);
+    bool ok = m_handler.on_number(d);
+    end_value();
+    return event(ok, p);
+}
+
+// p is at the opening quote of a key (in ST_OBJECT_FIRST or ST_KEY) or of a string value
+template <class Handler>
+const char* GenericStreamParser<Handler>::start_string(const char* p, const char* end) noexcept {
+    m_in_key = (m_state == ST_OBJECT_FIRST || m_state == ST_KEY);
+    if (*p != '\"') return fail(PARSE_MISS_KEY, p);
+    const char* start = p + 1;
+    const char* q = scan_string(start, end);
+    // a string without escapes inside this chunk is passed as a view, as parse() does
+    if (q < end && *q == '\"') return end_string(string_view(start, q - start), q + 1);
+    m_buf.assign(start, q - start);
+    m_state = ST_STRING;
+    return q;
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::parse_string(const char* p, const char* end) noexcept {
+    while (p < end) {
+        char ch = *p;
+        unsigned digit;
+        switch (m_state) {
+            case ST_STRING :
+                if (ch == '\"') return end_string(m_buf, p + 1);
+                if (ch == '\\') {
+                    m_state = ST_ESCAPE;
+                    ++p;
+                } else if ((unsigned char)ch < 0x20) {
+                    return fail(PARSE_INVALID_STRING_CHAR, p);
+                } else {
+                    // bulk append the next run of plain chars
+                    const char* q = scan_string(p, end);
+                    m_buf.append(p, q - p);
+                    p = q;
+                }
+                break;
+            case ST_ESCAPE :
+                m_state = ST_STRING;
+                switch (ch) {
+                    case '\"' : m_buf += '\"'; break;
+                    case '\\' : m_buf += '\\'; break;
+                    case '/'  : m_buf += '/';  break;
+                    case 'b'  : m_buf += '\b'; break;
+                    case 'f'  : m_buf += '\f'; break;
+                    case 'n'  : m_buf += '\n'; break;
+                    case 'r'  : m_buf += '\r'; break;
+                    case 't'  : m_buf += '\t'; break;
+                    case 'u'  :
+                        m_state = ST_HEX;
+                        m_hex = m_hex_count = 0;
+                        break;
+                    default : return fail(PARSE_INVALID_STRING_ESCAPE, p);
+                }
+                ++p;
+                break;
+            case ST_HEX : case ST_HEX_LOW :
+                if (ch >= '0' && ch <= '9') digit = ch - '0';
+                else if (ch >= 'A' && ch <= 'F') digit = ch - 'A' + 10;
+                else if (ch >= 'a' && ch <= 'f') digit = ch - 'a' + 10;
+                else return fail(PARSE_INVALID_UNICODE_HEX, p);
+                m_hex = (m_hex << 4) | digit;
+                ++p;
+                if (++m_hex_count < 4) break;
+                if (m_state == ST_HEX && m_hex >= 0xD800 && m_hex <= 0xDBFF) {
+                    m_high = m_hex;
+                    m_state = ST_SURROGATE;
+                    break;
+                }
+                if (m_state == ST_HEX_LOW) {
+                    if (m_hex < 0xDC00 || m_hex > 0xDFFF) return fail(PARSE_INVALID_UNICODE_SURROGATE, p);
+                    m_hex = (((m_high - 0xD800) << 10) | (m_hex - 0xDC00)) + 0x10000;
+                }
+                encode_utf8(m_buf, m_hex);
+                m_state = ST_STRING;
+                break;
+            case ST_SURROGATE :
+                if (ch != '\\') return fail(PARSE_INVALID_UNICODE_SURROGATE, p);
+                m_state = ST_SURROGATE_U;
+                ++p;
+                break;
+            default :
+                if (ch != 'u') return fail(PARSE_INVALID_UNICODE_SURROGATE, p);
+                m_state = ST_HEX_LOW;
+                m_hex = m_hex_count = 0;
+                ++p;
+        }
+    }
+    return p;
+}
+
+template <class Handler>
+const char* GenericStreamParser<Handler>::end_string(string_view str, const char* p) noexcept {
+    if (m_in_key) {
+        m_key.assign(str.data(), str.size());
+        m_state = ST_COLON;
+        return p;
+    }
+    bool ok = m_handler.on_string(str);
+    end_value();
+    return event(ok, p);
+}
+
+};
+
+#endif
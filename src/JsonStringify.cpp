@@ -1,49 +1,78 @@
 #include "JsonStringify.h"
+#include "JsonNumber.h"
+#include "JsonSimd.h"
 #include <cassert>
+#include <algorithm>    // max
+#include <cmath>        // isfinite
+#include <cstring>      // memcpy
 
 namespace myJson {
 
-// define all member functions declared in Generator class
-Generator::Generator(const JsonValue& jv, string& res) : m_res(res) {
+// json has no NaN or infinity, they are written as null (as JSON.stringify does), both here and in number_size()
+static inline char* write_number(double d, char* buf) noexcept {
+    if (!isfinite(d)) {
+        memcpy(buf, "null", 4);
+        return buf + 4;
+    }
+    return double_to_chars(d, buf);
+}
+
+// define all member functions declared in GenericGenerator class
+template <class Out>
+GenericGenerator<Out>::GenericGenerator(const JsonValue& jv, Out& sink) : m_sink(sink), m_depth(0) {
     stringify_value(jv);
 }
 
-void Generator::stringify_value(const JsonValue& jv) {
+template <class Out>
+void GenericGenerator<Out>::stringify_value(const JsonValue& jv) {
     // declare variables outside when jump into switch clauses, or error : jump to case label [-fpermissive]
     size_t i = 0;
-    double tmp = 0;
-    char buf[32] = {0};
+    JSON_STAT(++m_stats.nodes[jv.get_type()]);
     switch (jv.get_type()) {
-        case JSON_NULL  : m_res += "null"; break;
-        case JSON_TRUE  : m_res += "true"; break;
-        case JSON_FALSE : m_res += "false"; break;
+        case JSON_NULL  : m_sink.write("null", 4); JSON_STAT(m_stats.bytes += 4); break;
+        case JSON_TRUE  : m_sink.write("true", 4); JSON_STAT(m_stats.bytes += 4); break;
+        case JSON_FALSE : m_sink.write("false", 5); JSON_STAT(m_stats.bytes += 5); break;
         case JSON_NUMBER :
-            // to_string() is not accessible here, coz the precision will be changed, use %.17g to assign precision by your own
-            sprintf(buf, "%.17g", jv.get_number());
-            m_res += buf;
+            // shortest digits which round-trip, written straight into the buffer of the sink, see JsonNumber.h
+            {
+                char* start = m_sink.reserve(32);
+                char* end = write_number(jv.get_number(), start);
+                m_sink.commit(end);
+                JSON_STAT(m_stats.bytes += end - start);
+                JSON_STAT(++m_stats.numbers);
+            }
             break;
         case JSON_STRING :
             this->stringify_string(jv.get_string());
             break;
         case JSON_ARRAY :
-            m_res += '[';
+            // brackets and commas, see get_stringify_size()
+            JSON_STAT(m_stats.bytes += jv.get_array_size() ? jv.get_array_size() + 1 : 2);
+            JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+            m_sink.put('[');
             for (i = 0; i < jv.get_array_size(); ++i) {
-                if (i > 0) m_res += ',';
+                if (i > 0) m_sink.put(',');
                 this->stringify_value(jv.get_array_element(i));
             }
-            m_res += ']';
+            m_sink.put(']');
+            JSON_STAT(--m_depth);
             break;
         case JSON_OBJECT :
-            m_res += '{';
+            // braces, commas and colons
+            JSON_STAT(m_stats.bytes += jv.get_object_size() ? 2 * jv.get_object_size() + 1 : 2);
+            JSON_STAT(m_stats.keys += jv.get_object_size());
+            JSON_STAT(m_stats.max_depth = max(m_stats.max_depth, ++m_depth));
+            m_sink.put('{');
             i = 0;
-            for (auto itr : jv.get_object()) {
-                if (i > 0) m_res += ',';
+            for (const auto& itr : jv.get_object()) {
+                if (i > 0) m_sink.put(',');
                 this->stringify_string(itr.first);
-                m_res += ':';
+                m_sink.put(':');
                 this->stringify_value(itr.second);
                 ++i;
             }
-            m_res += '}';
+            m_sink.put('}');
+            JSON_STAT(--m_depth);
             break;
         default :
             assert(0 && "invalid type");
@@ -51,28 +80,72 @@ void Generator::stringify_value(const JsonValue& jv) {
     }
 }
 
-void Generator::stringify_string(const string& str) {
-    m_res += "\"";
-    for (auto ch : str) {
-        switch(ch) {
-            case '\"' : m_res += "\\\""; break;
-            case '\\' : m_res += "\\\\"; break;
-            case '\b' : m_res += "\\b";  break;
-            case '\f' : m_res += "\\f";  break;
-            case '\n' : m_res += "\\n";  break;
-            case '\r' : m_res += "\\r";  break;
-            case '\t' : m_res += "\\t";  break;
-            default :
-                if (ch < 0x20) {
-                    char buf[7] = {0};
-                    sprintf(buf, "\\u%04X", ch);
-                    m_res += buf;
-                } else {
-                    m_res += ch;
-                }
+// escape sequence of every control char, the short form where json has one
+static const char* const CONTROL_ESCAPES[0x20] = {
+    "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+    "\\b",     "\\t",     "\\n",     "\\u000B", "\\f",     "\\r",     "\\u000E", "\\u000F",
+    "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+    "\\u0018", "\\u0019", "\\u001A", "\\u001B", "\\u001C", "\\u001D", "\\u001E", "\\u001F"
+};
+
+// the first byte which needs escaping, short runs (most keys among them) are not worth a call into the SIMD kernel
+static inline const char* find_escape(const char* p, const char* end) noexcept {
+    if (end - p >= 16) return scan_string(p, end);
+    while (p < end && (unsigned char)*p >= 0x20 && *p != '\"' && *p != '\\') ++p;
+    return p;
+}
+
+template <class Out>
+size_t GenericGenerator<Out>::number_size(double d) noexcept {
+    char buf[32];
+    return write_number(d, buf) - buf;
+}
+
+template <class Out>
+size_t GenericGenerator<Out>::string_size(string_view str) noexcept {
+    const char* p = str.data();
+    const char* end = p + str.size();
+    size_t size = str.size() + 2;
+    while ((p = find_escape(p, end)) != end) {
+        unsigned char ch = (unsigned char)*p++;
+        // every escaped byte grows by one, or by five as \u00XX
+        size += (ch < 0x20 && CONTROL_ESCAPES[ch][1] == 'u') ? 5 : 1;
+    }
+    return size;
+}
+
+template <class Out>
+void GenericGenerator<Out>::stringify_string(string_view str) {
+    const char* p = str.data();
+    const char* end = p + str.size();
+    JSON_STAT(m_stats.string_bytes += str.size());
+    JSON_STAT(m_stats.bytes += str.size() + 2);
+    m_sink.put('\"');
+    while (true) {
+        // find_escape() stops exactly at the bytes which need escaping, the runs in between are copied as they are
+        const char* q = find_escape(p, end);
+        m_sink.write(p, q - p);
+        if (q == end) break;
+        // char is signed, bytes of UTF-8 sequences must not be taken for control chars
+        unsigned char ch = (unsigned char)*q;
+        if (ch < 0x20) {
+            const char* esc = CONTROL_ESCAPES[ch];
+            m_sink.write(esc, esc[1] == 'u' ? 6 : 2);
+            JSON_STAT(m_stats.bytes += esc[1] == 'u' ? 5 : 1);
+        } else {
+            char* out = m_sink.reserve(2);
+            out[0] = '\\';
+            out[1] = (char)ch;
+            m_sink.commit(out + 2);
+            JSON_STAT(++m_stats.bytes);
         }
+        JSON_STAT(++m_stats.escapes);
+        p = q + 1;
     }
-    m_res += "\"";
+    m_sink.put('\"');
 }
-    
+
+template class GenericGenerator<Sink>;
+template class GenericGenerator<ExactWriter>;
+
 };
\ No newline at end of file
@@ -1,26 +1,42 @@
 #ifndef JSON_STRINGIFY_H
 #define JSON_STRINGIFY_H
 #include "JsonValue.h"
+#include "JsonSink.h"
+#include "JsonStats.h"
 
 namespace myJson {
 
-// define Generator class, stringify from existed json to string
-class Generator {
+// define Generator class, stringify from existed json to a Sink
+// Out is Sink, or ExactWriter for a string sized by get_stringify_size() first, both are instantiated in JsonStringify.cpp
+template <class Out>
+class GenericGenerator {
 public:
-    Generator(const JsonValue& jv, string& res);
+    GenericGenerator(const JsonValue& jv, Out& sink);
     // notice that if we don't define dtor here, error "undefined reference" will occur
-    ~Generator() {}
+    ~GenericGenerator() {}
+
+    // exact lengths of what stringify_value() writes for a number and for a string with its quotes, see get_stringify_size()
+    static size_t number_size(double d) noexcept;
+    static size_t string_size(string_view str) noexcept;
+
+    // counters of what was written, all zero unless built with JSON_STATS, see JsonStats.h
+    const Stats& get_stats() const noexcept { return m_stats; }
 
 private:
-    Generator(const Generator&) = delete;
+    GenericGenerator(const GenericGenerator&) = delete;
     void stringify_value(const JsonValue& jv);
-    void stringify_string(const string& str);
+    void stringify_string(string_view str);
 
 private:
-    // store stringify info from json
-    string& m_res;
+    // everything is written through it, the caller flushes
+    Out& m_sink;
+    // only touched through JSON_STAT(), m_depth is the number of open arrays and objects
+    Stats m_stats;
+    size_t m_depth;
 };
 
+using Generator = GenericGenerator<Sink>;
+
 };
 
 #endif
\ No newline at end of file
@@ -1,83 +1,352 @@
 #include "JsonValue.h"
 #include "JsonParser.h"
 #include "JsonStringify.h"
+#include "JsonFile.h"
 #include <cassert>
+#include <cstring>  // strlen
 
 namespace myJson {
 
 // define all functions declared in JsonValue.h
 // ctor dtor cctor rvalue etc
-JsonValue::JsonValue() noexcept : m_type(JSON_NULL) {}
+JsonValue::JsonValue() noexcept : m_type(JSON_NULL), m_borrowed(false), m_link(false), m_size(SIZE_UNKNOWN), m_res(pmr::get_default_resource()) {}
+
+JsonValue::JsonValue(const allocator_type& alloc) noexcept : m_type(JSON_NULL), m_borrowed(false), m_link(false), m_size(SIZE_UNKNOWN), m_res(alloc.resource()) {}
 
 JsonValue::~JsonValue() noexcept {
     free();
 }
 
-JsonValue::JsonValue(const JsonValue& rhs) noexcept {
+JsonValue::JsonValue(const JsonValue& rhs) noexcept : m_res(pmr::get_default_resource()) {
     init(rhs);
 }
 
-JsonValue& JsonValue::operator=(const JsonValue& rhs) noexcept {
-    free();
+JsonValue::JsonValue(const JsonValue& rhs, const allocator_type& alloc) noexcept : m_res(alloc.resource()) {
     init(rhs);
+}
+
+JsonValue& JsonValue::operator=(const JsonValue& rhs) noexcept {
+    // copy into a tmp first, rhs may be a child of this value and would be destroyed by free()
+    JsonValue tmp(rhs, get_allocator());
+    return *this = std::move(tmp);
+}
+
+JsonValue::JsonValue(JsonValue&& rhs) noexcept : m_res(rhs.m_res) {
+    init(std::move(rhs));
+}
+
+JsonValue::JsonValue(JsonValue&& rhs, const allocator_type& alloc) noexcept : m_res(alloc.resource()) {
+    init(std::move(rhs));
+}
+
+JsonValue& JsonValue::operator=(JsonValue&& rhs) noexcept {
+    if (this != &rhs) {
+        // same reason as copy assignment, detach rhs (keeping its resource) before freeing current containers
+        JsonValue tmp(std::move(rhs));
+        free();
+        init(std::move(tmp));
+    }
     return *this;
 }
 
+JsonValue::allocator_type JsonValue::get_allocator() const noexcept {
+    return allocator_type(m_res);
+}
+
 // parse/stringify function
-int JsonValue::parse(const string& json) noexcept {
-    Parser p(*this, json);
-    int res = p.parse();
+int JsonValue::parse(string_view json, PARSE_ENGINE engine) noexcept {
+    return parse(json.data(), json.size(), engine);
+}
+
+int JsonValue::parse(const char* json, PARSE_ENGINE engine) noexcept {
+    return parse(json, strlen(json), engine);
+}
+
+int JsonValue::parse_file(const string& path, PARSE_ENGINE engine) noexcept {
+    MappedFile file(path);
+    if (!file.is_open()) {
+        set_type(JSON_NULL);
+        return PARSE_FILE_ERROR;
+    }
+    // strings are copied out of the text while parsing, so the tree does not need the mapping afterwards
+    return parse(file.data(), file.size(), engine);
+}
+
+int JsonValue::parse_insitu(char* json, size_t len) noexcept {
+    DomHandler handler(*this, true);
+    Parser p(handler, json, json + len);
+    int res = p.parse_insitu();
+    if (res != PARSE_OK) {
+        set_type(JSON_NULL);
+    }
+    return res;
+}
+
+int JsonValue::parse(const char* json, size_t len, PARSE_ENGINE engine) noexcept {
+    return parse_text(json, len, engine, nullptr);
+}
+
+int JsonValue::parse(string_view json, Stats& stats, PARSE_ENGINE engine) noexcept {
+    return parse_text(json.data(), json.size(), engine, &stats);
+}
+
+int JsonValue::parse_text(const char* json, size_t len, PARSE_ENGINE engine, Stats* stats) noexcept {
+#if JSON_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    DomHandler handler(*this);
+    Parser p(handler, json, json + len);
+    int res = (engine == ENGINE_STAGED) ? p.parse_staged() : p.parse();
+    // children are built inside this value directly, so one reset here frees every half-built subtree
+    if (res != PARSE_OK) {
+        set_type(JSON_NULL);
+    }
+    if (stats != nullptr) {
+        *stats = p.get_stats();
+        JSON_STAT(stats->allocs = handler.get_allocs());
+        JSON_STAT(stats->seconds = stat_seconds(start));
+    }
     return res;
 }
 
-void JsonValue::stringify(string& str) const noexcept {
-    Generator(*this, str);
+void JsonValue::stringify(string& str, bool exact_size) const noexcept {
+    generate(str, exact_size, nullptr);
+}
+
+void JsonValue::stringify(string& str, Stats& stats, bool exact_size) const noexcept {
+    generate(str, exact_size, &stats);
+}
+
+void JsonValue::generate(string& str, bool exact_size, Stats* stats) const noexcept {
+#if JSON_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    if (exact_size) {
+        // the string is allocated once and the text written straight into it, MIN_ROOM is the slack reserve() may use
+        // resize() zero-fills that room first, which costs about what the copy out of a StringSink chunk would
+        size_t old = str.size(), size = get_stringify_size();
+        str.resize(old + size + Sink::MIN_ROOM);
+        ExactWriter writer(&str[old]);
+        GenericGenerator<ExactWriter> g(*this, writer);
+        assert(writer.get_pos() == str.data() + old + size);
+        str.resize(old + size);
+        if (stats != nullptr) *stats = g.get_stats();
+    } else {
+        StringSink sink(str);
+        Generator g(*this, sink);
+        if (stats != nullptr) *stats = g.get_stats();
+    }
+    if (stats != nullptr) {
+        JSON_STAT(stats->seconds = stat_seconds(start));
+    }
+}
+
+size_t JsonValue::get_stringify_size() const noexcept {
+    // the target keeps the size, a link is never changed in place
+    if (m_link) return m_node->get_stringify_size();
+    uint32_t cached = m_size.load(memory_order_relaxed);
+    if (cached != SIZE_UNKNOWN) return cached;
+    size_t size = 0;
+    switch (m_type) {
+        case JSON_NULL : case JSON_TRUE : size = 4; break;
+        case JSON_FALSE : size = 5; break;
+        case JSON_NUMBER : size = Generator::number_size(m_num); break;
+        case JSON_STRING : size = Generator::string_size(get_string()); break;
+        case JSON_ARRAY :
+            // brackets and commas
+            size = m_arr.empty() ? 2 : m_arr.size() + 1;
+            for (const auto& jv : m_arr) size += jv.get_stringify_size();
+            break;
+        case JSON_OBJECT :
+            // braces, commas and colons
+            size = m_obj.empty() ? 2 : 2 * m_obj.size() + 1;
+            for (const auto& itr : m_obj) {
+                size += Generator::string_size(itr.first) + itr.second.get_stringify_size();
+            }
+            break;
+        default :
+            break;
+    }
+    // several threads may store the same number, which is harmless
+    if (size < SIZE_UNKNOWN) m_size.store((uint32_t)size, memory_order_relaxed);
+    return size;
+}
+
+bool JsonValue::stringify(Sink& sink) const noexcept {
+    return generate(sink, nullptr);
+}
+
+bool JsonValue::stringify(Sink& sink, Stats& stats) const noexcept {
+    return generate(sink, &stats);
+}
+
+bool JsonValue::generate(Sink& sink, Stats* stats) const noexcept {
+#if JSON_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    Generator g(*this, sink);
+    bool ok = sink.flush();
+    if (stats != nullptr) {
+        *stats = g.get_stats();
+        JSON_STAT(stats->seconds = stat_seconds(start));
+    }
+    return ok;
 }
 
 // init/free function
-void JsonValue::init(const JsonValue& rhs) noexcept {
+void JsonValue::init(const JsonValue& other) noexcept {
+    // a link is copied as the value it points at, so copies never share anything with the tree of rhs
+    const JsonValue& rhs = other.resolve();
     m_type = rhs.m_type;
+    m_borrowed = false;
+    m_link = false;
+    // the copy stringifies to the same text
+    m_size.store(rhs.m_size.load(memory_order_relaxed), memory_order_relaxed);
     switch (m_type) {
         case JSON_NUMBER : 
             m_num = rhs.m_num;     // 0 -> double
             break;
         case JSON_STRING : 
-            new(&m_str) string(rhs.m_str);
+            // a borrowed string is copied as well, copies never depend on the text
+            new(&m_str) String(rhs.get_string(), get_allocator());
             break;
         case JSON_ARRAY :
-            // m_arr = vector<JsonValue>(rhs.m_arr);
-            new(&m_arr) vector<JsonValue>(rhs.m_arr);
+            // every element is copied with our allocator as well, see uses-allocator construction
+            new(&m_arr) Array(rhs.m_arr, get_allocator());
             break;
         case JSON_OBJECT :
-            // m_obj = map<string, JsonValue>(rhs.m_obj);
-            new(&m_obj) map<string, JsonValue>(rhs.m_obj);
+            new(&m_obj) Object(rhs.m_obj, get_allocator());
             break;
         default :
             break;
     }
 }
 
+void JsonValue::init(JsonValue&& rhs) noexcept {
+    if (rhs.m_link && rhs.m_res != m_res) {
+        // a link only moves within its resource, e.g. one moved into a Document arena would never be released
+        init(rhs);
+        rhs.free();
+        return;
+    }
+    m_type = rhs.m_type;
+    m_borrowed = rhs.m_borrowed;
+    m_link = rhs.m_link;
+    m_size.store(rhs.m_size.load(memory_order_relaxed), memory_order_relaxed);
+    if (m_link) {
+        new(&m_node) Node(std::move(rhs.m_node));
+        rhs.free();
+        return;
+    }
+    switch (m_type) {
+        case JSON_NUMBER : 
+            m_num = rhs.m_num;
+            break;
+        case JSON_STRING : 
+            if (m_borrowed) {
+                m_view = rhs.m_view;
+                break;
+            }
+            // allocator-extended move ctor steals storage only if both sides share one resource
+            new(&m_str) String(std::move(rhs.m_str), get_allocator());
+            break;
+        case JSON_ARRAY :
+            new(&m_arr) Array(std::move(rhs.m_arr), get_allocator());
+            break;
+        case JSON_OBJECT :
+            new(&m_obj) Object(std::move(rhs.m_obj), get_allocator());
+            break;
+        default :
+            break;
+    }
+    // moved-from containers still need their dtor, free() calls it and resets rhs to JSON_NULL
+    rhs.free();
+}
+
 void JsonValue::free() noexcept {
     // using exised function to destroy JsonValue
+    if (m_link) {
+        m_node.~Node();
+        m_type = JSON_NULL;
+    }
     switch (m_type) {
         case JSON_STRING : 
-            m_str.~basic_string();
+            if (!m_borrowed) m_str.~basic_string();
             break;
         case JSON_ARRAY :
-            m_arr.~vector<JsonValue>();
+            m_arr.~Array();
             break;
         case JSON_OBJECT :
-            m_obj.~map<string, JsonValue>();
+            m_obj.~Object();
             break;
         default :
             break;
     }
     m_type = JSON_NULL;
+    m_borrowed = false;
+    m_link = false;
+    touch();
+}
+
+void JsonValue::borrow_string(string_view str) noexcept {
+    free();
+    m_type = JSON_STRING;
+    m_borrowed = true;
+    m_view = str;
+}
+
+void JsonValue::link(const JsonValue& target, const Node& owner) noexcept {
+    free();
+    m_type = target.m_type;
+    m_link = true;
+    if (target.m_link) {
+        new(&m_node) Node(target.m_node);
+    } else {
+        // aliasing ctor, m_node points at target but owns its whole tree
+        new(&m_node) Node(owner, const_cast<JsonValue*>(&target));
+    }
+}
+
+void JsonValue::share(const JsonValue& rhs, const Node& owner) noexcept {
+    free();
+    switch (rhs.m_type) {
+        case JSON_ARRAY :
+            m_type = JSON_ARRAY;
+            new(&m_arr) Array(rhs.m_arr.size(), get_allocator());
+            for (size_t i = 0; i < m_arr.size(); ++i) {
+                m_arr[i].link(rhs.m_arr[i], owner);
+            }
+            break;
+        case JSON_OBJECT :
+            m_type = JSON_OBJECT;
+            new(&m_obj) Object(get_allocator());
+            m_obj.assign_keys(rhs.m_obj);
+            for (size_t i = 0; i < m_obj.size(); ++i) {
+                m_obj.value(i).link(rhs.m_obj[i].second, owner);
+            }
+            break;
+        default :
+            // nothing below it to share
+            init(rhs);
+            break;
+    }
+    // the copy stringifies to the same text
+    m_size.store(rhs.m_size.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+const JsonValue& JsonValue::slot(size_t index) const noexcept {
+    assert(m_type == JSON_ARRAY && !m_link && index < m_arr.size());
+    return m_arr[index];
+}
+
+const JsonValue& JsonValue::slot(string_view key) const noexcept {
+    assert(m_type == JSON_OBJECT && !m_link && find_object_key(key));
+    return m_obj[m_obj.find(key)].second;
 }
 
 // all kinds of API provided for user 
 JSON_TYPE JsonValue::get_type() const noexcept {
-    return m_type;
+    return (JSON_TYPE)m_type;
 }
 
 void JsonValue::set_type(JSON_TYPE type) noexcept {
@@ -87,7 +356,7 @@ void JsonValue::set_type(JSON_TYPE type) noexcept {
 
 double JsonValue::get_number() const noexcept {
     assert(m_type == JSON_NUMBER);
-    return m_num;
+    return resolve().m_num;
 }
 
 void JsonValue::set_number(double d) noexcept {
@@ -96,44 +365,86 @@ void JsonValue::set_number(double d) noexcept {
     m_num = d;
 }
 
-const string& JsonValue::get_string() const noexcept {
+string_view JsonValue::get_string() const noexcept {
     assert(m_type == JSON_STRING);
-    return m_str;
+    const JsonValue& jv = resolve();
+    return jv.m_borrowed ? jv.m_view : string_view(jv.m_str);
 }   
 
+string JsonValue::get_string_copy() const noexcept {
+    return string(get_string());
+}
+
 size_t JsonValue::get_string_length() const noexcept {
     assert(m_type == JSON_STRING);
-    return m_str.size();
+    return get_string().size();
+}
+
+void JsonValue::set_string(string_view str) noexcept {
+    touch();
+    if (m_type == JSON_STRING && !m_borrowed && !m_link) {
+        m_str.assign(str.data(), str.size());
+    } else {
+        free();
+        m_type = JSON_STRING;
+        new(&m_str) String(str.data(), str.size(), get_allocator());
+    }
+}
+
+void JsonValue::set_string(const char* str) noexcept {
+    set_string(string_view(str));
+}
+
+void JsonValue::set_string(string&& str) noexcept {
+    set_string(string_view(str));
 }
 
-void JsonValue::set_string(const string& str) noexcept {
-    if (m_type == JSON_STRING) {
-        m_str = str;
+void JsonValue::set_string(String&& str) noexcept {
+    touch();
+    if (m_type == JSON_STRING && !m_borrowed && !m_link) {
+        m_str = std::move(str);
     } else {
         free();
         m_type = JSON_STRING;
-        new(&m_str) string(str);
+        new(&m_str) String(std::move(str), get_allocator());
     }
 }
 
-void JsonValue::set_array(const vector<JsonValue> &arr) noexcept {
-    if (m_type == JSON_ARRAY) {
+void JsonValue::set_array(const Array& arr) noexcept {
+    touch();
+    if (m_type == JSON_ARRAY && !m_link) {
         m_arr = arr;
     } else {
         free();
         m_type = JSON_ARRAY;
-        new(&m_arr) vector<JsonValue>(arr);
+        new(&m_arr) Array(arr, get_allocator());
+    }
+}
+
+void JsonValue::set_array(Array&& arr) noexcept {
+    touch();
+    if (m_type == JSON_ARRAY && !m_link) {
+        m_arr = std::move(arr);
+    } else {
+        free();
+        m_type = JSON_ARRAY;
+        new(&m_arr) Array(std::move(arr), get_allocator());
     }
 }
 
+void JsonValue::set_array(const vector<JsonValue>& arr) noexcept {
+    // uses-allocator construction copies every element with our allocator, then the vector is moved in without another copy
+    set_array(Array(arr.begin(), arr.end(), get_allocator()));
+}
+
 size_t JsonValue::get_array_size() const noexcept {
     assert(m_type == JSON_ARRAY);
-    return m_arr.size();
+    return resolve().m_arr.size();
 }
 
 size_t JsonValue::get_array_capacity() const noexcept {
     assert(m_type == JSON_ARRAY);
-    return m_arr.capacity();
+    return resolve().m_arr.capacity();
 }
 
 void JsonValue::reserve_array(size_t capacity) noexcept {
@@ -148,84 +459,127 @@ void JsonValue::shrink_array() noexcept {
 
 void JsonValue::clear_array() noexcept {
     assert(m_type == JSON_ARRAY);
+    touch();
     m_arr.clear();
 }
 
 const JsonValue& JsonValue::get_array_element(size_t index) const noexcept {
-    assert(m_type == JSON_ARRAY);
-    return m_arr[index];
+    return resolve().slot(index).resolve();
 }
 
 void JsonValue::pushback_array_element(const JsonValue& jv) noexcept {
     assert(m_type == JSON_ARRAY);
+    touch();
     m_arr.push_back(jv);
 }
 
+void JsonValue::pushback_array_element(JsonValue&& jv) noexcept {
+    assert(m_type == JSON_ARRAY);
+    touch();
+    m_arr.push_back(std::move(jv));
+}
+
 void JsonValue::popback_array_element() noexcept {
     assert(m_type == JSON_ARRAY);
+    touch();
     m_arr.pop_back();
 }
 
 void JsonValue::insert_array_element(size_t index, const JsonValue& jv) noexcept{
     assert(m_type == JSON_ARRAY && get_array_size() >= index);
+    touch();
     m_arr.insert(m_arr.begin() + index, jv);
 }
 
+void JsonValue::insert_array_element(size_t index, JsonValue&& jv) noexcept{
+    assert(m_type == JSON_ARRAY && get_array_size() >= index);
+    touch();
+    m_arr.insert(m_arr.begin() + index, std::move(jv));
+}
+
 void JsonValue::erase_array_element(size_t index, size_t count) noexcept {
     assert(m_type == JSON_ARRAY && get_array_size() >= index + count);
+    touch();
     m_arr.erase(m_arr.begin() + index, m_arr.begin() + index + count);
 }
 
 size_t JsonValue::get_object_size() const noexcept {
     assert(m_type == JSON_OBJECT);
-    return m_obj.size();
+    return resolve().m_obj.size();
 }
 
-const map<string, JsonValue>& JsonValue::get_object() const noexcept {
+const JsonValue::Object& JsonValue::get_object() const noexcept {
     assert(m_type == JSON_OBJECT);
-    return m_obj;
+    return resolve().m_obj;
 }
 
-// using existed fuction in std::map
-void JsonValue::set_object(const map<string, JsonValue>& obj) noexcept {
-    if (m_type == JSON_OBJECT) {
+void JsonValue::set_object(const Object& obj) noexcept {
+    touch();
+    if (m_type == JSON_OBJECT && !m_link) {
         m_obj = obj;
     } else {
         free();
         m_type = JSON_OBJECT;
-        new(&m_obj) map<string, JsonValue>(obj);
+        new(&m_obj) Object(obj, get_allocator());
+    }
+}
+
+void JsonValue::set_object(Object&& obj) noexcept {
+    touch();
+    if (m_type == JSON_OBJECT && !m_link) {
+        m_obj = std::move(obj);
+    } else {
+        free();
+        m_type = JSON_OBJECT;
+        new(&m_obj) Object(std::move(obj), get_allocator());
+    }
+}
+
+void JsonValue::set_object(const map<string, JsonValue>& obj) noexcept {
+    Object tmp(get_allocator());
+    for (const auto& member : obj) {
+        tmp.insert(member.first) = member.second;
     }
+    set_object(std::move(tmp));
 }
 
 void JsonValue::clear_object() noexcept {
     assert(m_type == JSON_OBJECT);
+    touch();
     m_obj.clear();
 }
 
-bool JsonValue::find_object_key(const string& key) const noexcept {
+bool JsonValue::find_object_key(string_view key) const noexcept {
     assert(m_type == JSON_OBJECT);
-    return m_obj.find(key) != m_obj.end();
+    return resolve().m_obj.find(key) != Object::npos;
 }
 
-const JsonValue& JsonValue::get_object_value(const string& key) const noexcept {
-    assert(m_type == JSON_OBJECT && find_object_key(key));
-    // notice that we use 'at' here instead of [] to extract element in map
-    return m_obj.at(key);
+const JsonValue& JsonValue::get_object_value(string_view key) const noexcept {
+    return resolve().slot(key).resolve();
+}
+
+void JsonValue::set_object_value(string_view key, const JsonValue& val) noexcept {
+    // it is not neccessary to assure that key has existed, insert returns a JSON_NULL slot for a new key
+    assert(m_type == JSON_OBJECT);
+    touch();
+    m_obj.insert(key) = val;
 }
 
-void JsonValue::set_object_value(const string& key, const JsonValue& val) noexcept {
-    // it is not neccessary to assure that key has existed, coz we are gonna insert new pair [key, val] now
+void JsonValue::set_object_value(string_view key, JsonValue&& val) noexcept {
     assert(m_type == JSON_OBJECT);
-    if (find_object_key(key)) m_obj[key] = val;
-    else m_obj.insert({key, val});
+    touch();
+    m_obj.insert(key) = std::move(val);
 }
 
-void JsonValue::remove_object_value(const string& key) noexcept {
+void JsonValue::remove_object_value(string_view key) noexcept {
     assert(m_type == JSON_OBJECT && find_object_key(key));
-    m_obj.erase(key);
+    touch();
+    m_obj.erase(m_obj.find(key));
 }
 
-bool operator==(const JsonValue& lhs, const JsonValue& rhs) noexcept {
+bool operator==(const JsonValue& left, const JsonValue& right) noexcept {
+    const JsonValue& lhs = left.resolve();
+    const JsonValue& rhs = right.resolve();
     if (lhs.m_type != rhs.m_type) {
         return false;
     }
@@ -234,7 +588,7 @@ bool operator==(const JsonValue& lhs, const JsonValue& rhs) noexcept {
             return lhs.m_num == rhs.m_num;
             break;
         case JSON_STRING :
-            return lhs.m_str == rhs.m_str;
+            return lhs.get_string() == rhs.get_string();
             break;    
         case JSON_ARRAY :
             if (lhs.get_array_size() != rhs.get_array_size()) {
@@ -250,8 +604,10 @@ bool operator==(const JsonValue& lhs, const JsonValue& rhs) noexcept {
             if (lhs.get_object_size() != rhs.get_object_size()) {
                 return false;
             }
-            for (auto itr : lhs.m_obj) {
-                if (!rhs.find_object_key(itr.first) || itr.second != rhs.get_object_value(itr.first)) {
+            // members may come in different order, look up every key of lhs in rhs
+            for (const auto& itr : lhs.m_obj) {
+                size_t pos = rhs.m_obj.find(itr.first);
+                if (pos == JsonObject::npos || itr.second != rhs.m_obj[pos].second) {
                     return false;
                 }
             }
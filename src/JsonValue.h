@@ -1,9 +1,17 @@
 #ifndef JSON_VALUE_H
 #define JSON_VALUE_H
+#include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>           // shared_ptr
+#include <memory_resource>  // pmr containers, memory_resource
+#include <atomic>
+#include <cstdint>          // uint8_t, uint32_t
 #include "JsonEnum.h"
-#include "Json.h"
+#include "JsonObject.h"
+#include "JsonSink.h"
+#include "JsonStats.h"
 
 using namespace std;
 
@@ -12,28 +20,85 @@ namespace myJson {
 class JsonValue {
 
 public:
+    // all containers allocate through the memory_resource of their value (global heap by default, or a Document arena)
+    // children always share the resource of their parent, pmr containers pass it down by uses-allocator construction
+    using allocator_type = pmr::polymorphic_allocator<char>;
+    using String = pmr::string;
+    using Array = pmr::vector<JsonValue>;
+    // members keep insertion order, see JsonObject.h
+    using Object = JsonObject;
+    // how Json holds a value, see Json.h
+    using Node = shared_ptr<JsonValue>;
+
     // ctor dtor cctor rvalue etc
     JsonValue() noexcept;
+    explicit JsonValue(const allocator_type& alloc) noexcept;
     ~JsonValue() noexcept;
+    // copies use the global heap like pmr containers do, so a copied subtree never depends on an arena
     JsonValue(const JsonValue& rhs) noexcept;
+    JsonValue(const JsonValue& rhs, const allocator_type& alloc) noexcept;
     JsonValue& operator=(const JsonValue& rhs) noexcept;
+    // moves keep the resource of rhs, moving into another resource copies elements into it
+    JsonValue(JsonValue&& rhs) noexcept;
+    JsonValue(JsonValue&& rhs, const allocator_type& alloc) noexcept;
+    JsonValue& operator=(JsonValue&& rhs) noexcept;
+
+    allocator_type get_allocator() const noexcept;
 
     // parse/stringify function
-    int parse(const string& json) noexcept;
-    void stringify(string& str) const noexcept;
+    // the text is exactly json, nothing behind it is read, so it can point into any buffer
+    // a '\0' inside is a control char like others, i.e. invalid everywhere except escaped as \u0000 inside a string
+    int parse(string_view json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    int parse(const char* json, size_t len, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // a C string up to its '\0', also keeps parse("...", engine) from being ambiguous between the two above
+    int parse(const char* json, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // same as parse(json, engine), and fills stats in for this call, see JsonStats.h
+    int parse(string_view json, Stats& stats, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // parse in place, strings and keys are not copied but point into json, escaped ones are decoded over their own escapes
+    // (json is changed by that even if it turns out invalid later)
+    // json must stay alive and unchanged as long as this value (or any value moved out of it) is used, copies own their strings
+    // always uses ENGINE_RECURSIVE, the staged engine rescans the text to report errors, which is gone once strings are decoded
+    int parse_insitu(char* json, size_t len) noexcept;
+    // parse a file in place from a read-only mapping, without copying it into a string first
+    int parse_file(const string& path, PARSE_ENGINE engine = ENGINE_RECURSIVE) noexcept;
+    // appends to str, exact_size sizes the tree first (see get_stringify_size()), grows str once and writes straight into it
+    // that pays off for big trees which are stringified again and again, a fresh tree formats every number twice
+    void stringify(string& str, bool exact_size = false) const noexcept;
+    // writes through sink and flushes it, return false if any write failed, see JsonSink.h
+    bool stringify(Sink& sink) const noexcept;
+    // same as above, and fill stats in for this call
+    void stringify(string& str, Stats& stats, bool exact_size = false) const noexcept;
+    bool stringify(Sink& sink, Stats& stats) const noexcept;
+    // exact length of the text stringify() writes, kept on every value of the tree until that value changes
+    // so stringify(string&) reserves once, and a mostly unchanged tree is sized again from its untouched subtrees
+    size_t get_stringify_size() const noexcept;
 
     // all kinds of API provided for user, notice that all get-type functions can be set as const, which can be used in const objects, and set-type cannot
     JSON_TYPE get_type() const noexcept;
     void set_type(JSON_TYPE t) noexcept;
+    // the value a link stands for, or this value itself, see link() below
+    // get functions and copies go through it, so a link reads like the value it points at
+    const JsonValue& resolve() const noexcept { return m_link ? *m_node : *this; }
 
     double get_number() const noexcept;
     void set_number(double d) noexcept;
 
-    const string& get_string() const noexcept;
+    // a view of the own string, or of the text after parse_insitu()
+    // it used to be const string&, which a pmr or borrowed string can not give, get_string_copy() gives a std::string
+    string_view get_string() const noexcept;
+    string get_string_copy() const noexcept;
     size_t get_string_length() const noexcept;
-    void set_string(const string& str) noexcept;
-
-    void set_array(const vector<JsonValue> &arr) noexcept;
+    void set_string(string_view str) noexcept;
+    // exact match for literals, otherwise string_view and String&& overloads would be ambiguous
+    void set_string(const char* str) noexcept;
+    void set_string(String&& str) noexcept;
+    // kept from before pmr, a std::string has another allocator, so its chars are copied all the same
+    void set_string(string&& str) noexcept;
+
+    void set_array(const Array& arr) noexcept;
+    void set_array(Array&& arr) noexcept;
+    // kept from before pmr, the elements are copied into the resource of this value
+    void set_array(const vector<JsonValue>& arr) noexcept;
     size_t get_array_size() const noexcept;
     size_t get_array_capacity() const noexcept;
     void reserve_array(size_t capacity) noexcept;
@@ -41,34 +106,77 @@ public:
     void clear_array() noexcept;
     const JsonValue& get_array_element(size_t index) const noexcept;
     void pushback_array_element(const JsonValue& jv) noexcept;
+    void pushback_array_element(JsonValue&& jv) noexcept;
     void popback_array_element() noexcept;
     void insert_array_element(size_t index, const JsonValue& jv) noexcept;
+    void insert_array_element(size_t index, JsonValue&& jv) noexcept;
     void erase_array_element(size_t index, size_t count) noexcept;
 
-    const map<string, JsonValue>& get_object() const noexcept;
+    const Object& get_object() const noexcept;
+    void set_object(const Object& obj) noexcept;
+    void set_object(Object&& obj) noexcept;
+    // kept from before JsonObject, members are inserted in key order
     void set_object(const map<string, JsonValue>& obj) noexcept;
     size_t get_object_size() const noexcept;
     void clear_object() noexcept;
-    bool find_object_key(const string& key) const noexcept;
-    const JsonValue& get_object_value(const string& key) const noexcept;
-    void set_object_value(const string& key, const JsonValue& val) noexcept;
-    void remove_object_value(const string& key) noexcept;
+    bool find_object_key(string_view key) const noexcept;
+    const JsonValue& get_object_value(string_view key) const noexcept;
+    void set_object_value(string_view key, const JsonValue& val) noexcept;
+    void set_object_value(string_view key, JsonValue&& val) noexcept;
+    void remove_object_value(string_view key) noexcept;
 
 private:
-    // indicates type of current json
-    JSON_TYPE m_type;
+    // stringify size of a value which has not been sized since it last changed, or whose text is too long to be kept
+    static constexpr uint32_t SIZE_UNKNOWN = UINT32_MAX;
+
+    // indicates type of current json, a JSON_TYPE kept in one byte, so the four fields below share 8 bytes
+    // a link has the type of the value it points at
+    uint8_t m_type;
+    // JSON_STRING only, the string is m_view into a text parsed in place instead of m_str
+    bool m_borrowed;
+    // the value lives in another tree and m_node points at it, only trees behind a Json contain links, see Json::mut()
+    bool m_link;
+    // cache of get_stringify_size(), atomic because const values may be stringified by several threads at once
+    mutable atomic<uint32_t> m_size;
+    // where m_str/m_arr/m_obj get their memory from, never changes after construction
+    pmr::memory_resource* m_res;
 
     // be careful that union can not be named here, otherwise deleted ctor error would generate
     union {
         double m_num;
-        string m_str;
-        vector<JsonValue> m_arr;
-        map<string, JsonValue> m_obj;
+        String m_str;
+        string_view m_view;
+        Array m_arr;
+        Object m_obj;
+        Node m_node;
     };
 
-    // init/free function
+    // init/free function, the rvalue version steals containers from rhs and leaves it as JSON_NULL
     void init(const JsonValue& rhs) noexcept;
+    void init(JsonValue&& rhs) noexcept;
     void free() noexcept;
+    // every change of this value drops its cached size, parents are changed through their own members, so they drop theirs
+    void touch() noexcept { m_size.store(SIZE_UNKNOWN, memory_order_relaxed); }
+    // the string is not copied, see parse_insitu()
+    void borrow_string(string_view str) noexcept;
+    // turn this value into a link to target, owner keeps the tree of target alive
+    // a link to a link points at its target, so m_node never leads to another link
+    void link(const JsonValue& target, const Node& owner) noexcept;
+    // copy rhs without its children, every element or member value becomes a link to the one in rhs
+    void share(const JsonValue& rhs, const Node& owner) noexcept;
+    // the element or member value as it is stored, a link is not resolved
+    const JsonValue& slot(size_t index) const noexcept;
+    const JsonValue& slot(string_view key) const noexcept;
+    // what the public parse/stringify functions come down to, stats may be nullptr
+    int parse_text(const char* json, size_t len, PARSE_ENGINE engine, Stats* stats) noexcept;
+    void generate(string& str, bool exact_size, Stats* stats) const noexcept;
+    bool generate(Sink& sink, Stats* stats) const noexcept;
+
+    // DomHandler builds children directly inside m_arr/m_obj instead of copying a finished tmp container
+    friend class DomHandler;
+    // Json shares subtrees through links, JsonRef walks the elements of m_arr as they are stored
+    friend class Json;
+    friend class JsonRef;
 
     // override for ==/!= operator
     friend bool operator==(const JsonValue& lhs, const JsonValue& rhs) noexcept;
@@ -80,4 +188,4 @@ bool operator!=(const JsonValue& lhs, const JsonValue& rhs) noexcept;
 
 };
 
-#endif
\ No newline at end of file
+#endif